@@ -1,40 +1,58 @@
 #include <algorithm>
+#include <array>
+#include <memory>
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
 #include <QtCore/QDebug>
+#include <QtCore/QPointer>
 #include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 
 #include "flat_logs.h"
 
 namespace {
-QString levelToString(graph::LogRecord::Level level)
-{
-    static const QHash<graph::LogRecord::Level, QString> levels = {
-        {graph::LogRecord::Level::No, ""},
-        {graph::LogRecord::Level::Debug, "D"},
-        {graph::LogRecord::Level::Info, "I"},
-        {graph::LogRecord::Level::Warn, "W"},
-        {graph::LogRecord::Level::Error, "E"},
-        {graph::LogRecord::Level::Panic, "P"},
-        {graph::LogRecord::Level::Fatal, "F"},
-    };
+const QString &levelToString(graph::LogRecord::Level level)
+{
+    static const std::array<QString, 7> levels = {"", "D", "I", "W", "E", "P", "F"};
 
-    return levels.value(level, "");
+    return levels[static_cast<size_t>(level)];
 }
 
-QString levelToColor(graph::LogRecord::Level level)
+const QString &levelToColor(graph::LogRecord::Level level)
 {
-    static const QHash<graph::LogRecord::Level, QString> levels = {
-        {graph::LogRecord::Level::No, "#FFFFFF"},
-        {graph::LogRecord::Level::Debug, "#01DF74"},
-        {graph::LogRecord::Level::Info, "#0040FF"},
-        {graph::LogRecord::Level::Warn, "#DF7401"},
-        {graph::LogRecord::Level::Error, "#DF0101"},
-        {graph::LogRecord::Level::Panic, "#FE2E2E"},
-        {graph::LogRecord::Level::Fatal, "#FE2E2E"},
-    };
+    static const std::array<QString, 7> levels
+        = {"#FFFFFF", "#01DF74", "#0040FF", "#DF7401", "#DF0101", "#FE2E2E", "#FE2E2E"};
 
-    return levels.value(level, "#FFFFFF");
+    return levels[static_cast<size_t>(level)];
+}
+
+//! key=value pairs of the fields on one line, cut at maxLength characters
+QString makeSummary(const graph::LogRecord &record,
+                    const trace::Source &keeper,
+                    qsizetype maxLength)
+{
+    QString summary;
+    for (const auto &field : record.decodeFields(keeper)) {
+        if (summary.size() >= maxLength) {
+            break;
+        }
+        if (!summary.isEmpty()) {
+            summary.append(QLatin1String("; "));
+        }
+        summary.append(field.key.toString());
+        summary.append(QLatin1String(" = "));
+        summary.append(field.value.toString());
+    }
+
+    if (summary.size() > maxLength) {
+        summary.truncate(maxLength);
+    }
+    summary.replace(QLatin1Char('\n'), QLatin1Char(' '));
+    summary.replace(QLatin1Char('\r'), QLatin1Char(' '));
+    summary.squeeze();
+    return summary;
 }
 
 } // namespace
@@ -43,6 +61,7 @@ namespace components {
 
 FlatLogModel::FlatLogModel(QObject *parent)
     : QAbstractTableModel(parent)
+    , m_chunks(CachedChunks)
 {
     m_headers << "Level"
               << "Time"
@@ -58,17 +77,67 @@ const TraceGraph &FlatLogModel::getGraph()
 
 void FlatLogModel::setGraph(const TraceGraph &data)
 {
+    const bool hadSubtree = m_subtreeRoot != nullptr;
+    const bool wasIndexed = m_searchIndex != nullptr;
+
+    // rows point into the old graph, none is left once it may be released
+    beginResetModel();
     m_graph = data;
+    m_allIndexes.reset();
+    m_searchIndex.reset();
+    m_subtreeRoot = nullptr;
+    m_subtreeTrace = nullptr;
+    filterIndexes();
+    endResetModel();
+
+    if (hadSubtree) {
+        emit notifySubtreeRootChanged();
+    }
+    if (wasIndexed) {
+        emit notifySearchIndexedChanged();
+    }
     if (m_graph.data != nullptr) {
         emit notifyGraphChanged();
-        makeIndexes();
+        orderLogs();
     }
 }
 
+void FlatLogModel::orderLogs()
+{
+    // the rest of the trace screen shows up while logs are ordered
+    QPointer<FlatLogModel> model(this);
+    auto graph = m_graph.data;
+    QThreadPool::globalInstance()->start([model, graph]() {
+        const auto threadCount = QThread::idealThreadCount();
+        std::shared_ptr<const std::vector<graph::LogRef>> order
+            = std::make_shared<std::vector<graph::LogRef>>(graph::orderLogs(*graph, threadCount));
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [model, graph, order]() {
+                if (model && model->m_graph.data == graph) {
+                    model->makeIndexes(order);
+                }
+            },
+            Qt::QueuedConnection);
+
+        // logs show up before they can be searched
+        auto searchIndex = std::make_shared<const graph::LogSearchIndex>(
+            graph::LogSearchIndex::build(*order, threadCount));
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [model, order, searchIndex]() {
+                if (model && model->m_allIndexes == order) {
+                    model->setSearchIndex(searchIndex);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
 int FlatLogModel::rowCount(const QModelIndex &index) const
 {
     Q_UNUSED(index)
-    return m_indexes.size();
+    return static_cast<int>(rows().size());
 }
 
 int FlatLogModel::columnCount(const QModelIndex &index) const
@@ -82,7 +151,7 @@ QVariant FlatLogModel::data(const QModelIndex &index, int role) const
     if (!index.isValid()) {
         return {};
     }
-    if (index.row() >= m_indexes.size()) {
+    if (index.row() >= rowCount()) {
         return {};
     }
 
@@ -93,37 +162,160 @@ QVariant FlatLogModel::data(const QModelIndex &index, int role) const
     if (role == Qt::DisplayRole) {
         role = Level + index.column();
     }
-    auto &logIndex = m_indexes[index.row()];
-    auto recordIdx = logIndex.logIndex;
-    auto const &logRecord = logIndex.span->logs[recordIdx];
+    const auto row = index.row();
 
+    // no allocation per row, strings of a chunk are shared
     switch (role) {
     case Level:
-        return levelToString(logRecord.level);
+        return levelToString(level(row));
     case RawLevel:
-        return QVariant::fromValue(logRecord.level);
+        return QVariant::fromValue(level(row));
     case LevelColor:
-        return levelToColor(logRecord.level);
+        return levelToColor(level(row));
     case Time: {
-        const int64_t msec = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                 logRecord.timestamp.time_since_epoch())
-                                 .count();
-        const auto dt = QDateTime::fromMSecsSinceEpoch(msec);
-        return dt.time().toString("hh:mm:ss.zzz");
+        const auto *chunk = displayChunk(row);
+        if (chunk == nullptr) {
+            return QString();
+        }
+        return chunk->times[static_cast<size_t>(row % ChunkSize)];
+    }
+    case Span: {
+        const auto *chunk = displayChunk(row);
+        if (chunk == nullptr) {
+            return QString();
+        }
+        return chunk->spans[chunk->rowSpans[static_cast<size_t>(row % ChunkSize)]];
     }
-    case Span:
-        return logIndex.span->spanID;
     case Process:
-        return logIndex.span->process->name;
-    case Message:
-        return QVariant::fromValue(logRecord.fields);
+        return processName(row).toString();
+    case Summary: {
+        const auto *chunk = displayChunk(row);
+        if (chunk == nullptr) {
+            return QString();
+        }
+        return chunk->summaries[static_cast<size_t>(row % ChunkSize)];
+    }
+    case Message: {
+        // full fields are asked for on click only, escaped strings go away with the payload
+        const auto &record = rows()[static_cast<size_t>(row)].record();
+        LogFields fields;
+        fields.keeper = trace::Source::fromData(QByteArray());
+        fields.graph = m_graph.data;
+        fields.fields = record.decodeFields(*fields.keeper);
+        return QVariant::fromValue(fields);
+    }
     case HasError:
-        return logRecord.hasError;
+        return m_errorRows.test(static_cast<size_t>(row));
     }
 
     return {};
 }
 
+const FlatLogModel::Chunk *FlatLogModel::displayChunk(int row) const
+{
+    const auto index = row / ChunkSize;
+    const auto *chunk = m_chunks.object(index);
+    if (chunk == nullptr) {
+        // rows show up empty for a moment, the next chunks are likely asked for next
+        requestChunk(index - 1);
+        requestChunk(index);
+        requestChunk(index + 1);
+    }
+    return chunk;
+}
+
+void FlatLogModel::requestChunk(int index) const
+{
+    const auto &shown = rows();
+    if (index < 0 || static_cast<size_t>(index) * ChunkSize >= shown.size()
+        || m_chunks.contains(index) || m_pendingChunks.contains(index)) {
+        return;
+    }
+    m_pendingChunks.insert(index);
+
+    const auto first = static_cast<size_t>(index) * ChunkSize;
+    const auto last = std::min(first + ChunkSize, shown.size());
+    std::vector<graph::LogRef> logs(shown.cbegin() + static_cast<qsizetype>(first),
+                                    shown.cbegin() + static_cast<qsizetype>(last));
+    QPointer<FlatLogModel> model(const_cast<FlatLogModel *>(this));
+    const auto generation = m_chunkGeneration;
+    // rows always belong to m_graph, the worker keeps it alive while it reads their logs
+    QThreadPool::globalInstance()->start(
+        [model, graph = m_graph.data, logs = std::move(logs), generation, index]() {
+            auto chunk = std::make_shared<Chunk>(makeChunk(logs));
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [model, chunk, generation, index]() {
+                    if (model && model->m_chunkGeneration == generation) {
+                        model->insertChunk(index, std::move(*chunk));
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+}
+
+FlatLogModel::Chunk FlatLogModel::makeChunk(const std::vector<graph::LogRef> &logs)
+{
+    // escaped strings of the fields are copied into the summaries before the keeper goes away
+    const auto keeper = trace::Source::fromData(QByteArray());
+    Chunk chunk;
+    chunk.times.reserve(logs.size());
+    chunk.summaries.reserve(logs.size());
+    chunk.rowSpans.reserve(logs.size());
+
+    const graph::Span *lastSpan = nullptr;
+    for (const auto &logIndex : logs) {
+        const auto &logRecord = logIndex.record();
+
+        const int64_t msec = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 logRecord.timestamp.time_since_epoch())
+                                 .count();
+        chunk.times.push_back(
+            QDateTime::fromMSecsSinceEpoch(msec).time().toString("hh:mm:ss.zzz"));
+        chunk.summaries.push_back(makeSummary(logRecord, *keeper, SummaryLength));
+
+        // logs of one span come in runs, its ID is formatted once per run
+        if (logIndex.span != lastSpan) {
+            chunk.spans.push_back(logIndex.span->spanID.toString());
+            lastSpan = logIndex.span;
+        }
+        chunk.rowSpans.push_back(static_cast<quint32>(chunk.spans.size() - 1));
+    }
+
+    return chunk;
+}
+
+void FlatLogModel::insertChunk(int index, Chunk &&chunk)
+{
+    m_pendingChunks.remove(index);
+    m_chunks.insert(index, new Chunk(std::move(chunk)));
+
+    const auto first = index * ChunkSize;
+    const auto last = std::min(first + ChunkSize, rowCount()) - 1;
+    emit dataChanged(this->index(first, 0), this->index(last, columnCount() - 1));
+}
+
+graph::LogRecord::Level FlatLogModel::level(int row) const
+{
+    return m_levels[static_cast<size_t>(row)];
+}
+
+trace::Symbol FlatLogModel::processName(int row) const
+{
+    return m_processes[static_cast<size_t>(row)];
+}
+
+const graph::Bitmap &FlatLogModel::levelRows(graph::LogRecord::Level level) const
+{
+    return m_levelRows[static_cast<size_t>(level)];
+}
+
+const graph::Bitmap *FlatLogModel::processRows(trace::Symbol process) const
+{
+    const auto iter = m_processRows.constFind(process);
+    return iter != m_processRows.cend() ? &iter.value() : nullptr;
+}
+
 QVariant FlatLogModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (role != Qt::DisplayRole) {
@@ -136,37 +328,190 @@ QVariant FlatLogModel::headerData(int section, Qt::Orientation orientation, int
     return m_headers.at(section);
 }
 
-void FlatLogModel::makeIndexes()
+void FlatLogModel::makeIndexes(const std::shared_ptr<const std::vector<graph::LogRef>> &order)
 {
-    int logsRecords = 0;
-    for (int i = 0; i < m_graph.data->traces.size(); i++) {
-        const auto &trace = m_graph.data->traces[i];
-        for (int j = 0; j < trace->spans.size(); j++) {
-            logsRecords += trace->spans[j]->logs.size();
+    beginResetModel();
+    m_allIndexes = order;
+    filterIndexes();
+    endResetModel();
+}
+
+const std::vector<graph::LogRef> &FlatLogModel::rows() const
+{
+    static const std::vector<graph::LogRef> noLogs;
+    if (m_subtreeRoot != nullptr) {
+        return m_indexes;
+    }
+
+    return m_allIndexes != nullptr ? *m_allIndexes : noLogs;
+}
+
+void FlatLogModel::filterIndexes()
+{
+    m_indexes.clear();
+    m_indexRows.clear();
+    if (m_subtreeRoot != nullptr && m_allIndexes != nullptr) {
+        // a range check of preorder numbers per log, no walk over the children
+        const auto *root = m_subtreeRoot;
+        const auto *trace = m_subtreeTrace;
+        const auto &all = *m_allIndexes;
+        for (size_t i = 0; i < all.size(); ++i) {
+            if (trace->owns(*all[i].span) && root->contains(*all[i].span)) {
+                m_indexes.push_back(all[i]);
+                m_indexRows.push_back(static_cast<quint32>(i));
+            }
         }
     }
-    if (logsRecords == 0) {
-        return;
+
+    dropChunks();
+    makeColumns();
+}
+
+void FlatLogModel::setSearchIndex(const std::shared_ptr<const graph::LogSearchIndex> &index)
+{
+    // rows do not change, proxies search again on the signal
+    m_searchIndex = index;
+    emit notifySearchIndexedChanged();
+}
+
+bool FlatLogModel::searchIndexed() const
+{
+    return m_searchIndex != nullptr;
+}
+
+std::function<std::vector<quint32>()> FlatLogModel::searchTask(const QString &text) const
+{
+    if (m_allIndexes == nullptr || m_searchIndex == nullptr) {
+        return {};
     }
 
-    beginResetModel();
-    m_indexes.reserve(logsRecords);
-    for (int i = 0; i < m_graph.data->traces.size(); i++) {
-        const auto &trace = m_graph.data->traces[i];
-        for (int j = 0; j < trace->spans.size(); j++) {
-            auto span = trace->spans[j].get();
-
-            for (int k = 0; k < span->logs.size(); k++) {
-                LogIndex idx = {span, k};
-                m_indexes.emplace_back(idx);
+    // logs point into the graph
+    return [graph = m_graph.data,
+            logs = m_allIndexes,
+            index = m_searchIndex,
+            query = text.toUtf8()]() {
+        Q_UNUSED(graph)
+        return index->search(*logs, query);
+    };
+}
+
+graph::Bitmap FlatLogModel::shownRows(const std::vector<quint32> &matches) const
+{
+    graph::Bitmap found(rows().size());
+    if (m_subtreeRoot == nullptr) {
+        for (const auto row : matches) {
+            found.set(row);
+        }
+        return found;
+    }
+
+    // both are increasing rows of all logs
+    auto match = matches.cbegin();
+    for (size_t row = 0; row < m_indexRows.size() && match != matches.cend(); ++row) {
+        match = std::lower_bound(match, matches.cend(), m_indexRows[row]);
+        if (match != matches.cend() && *match == m_indexRows[row]) {
+            found.set(row);
+        }
+    }
+    return found;
+}
+
+void FlatLogModel::dropChunks()
+{
+    m_chunks.clear();
+    m_pendingChunks.clear();
+    ++m_chunkGeneration;
+}
+
+void FlatLogModel::makeColumns()
+{
+    const auto &shown = rows();
+    m_errorRows = graph::Bitmap(shown.size());
+
+    m_levels.resize(shown.size());
+    m_processes.resize(shown.size());
+    for (auto &bitmap : m_levelRows) {
+        bitmap = graph::Bitmap(shown.size());
+    }
+    m_processRows.clear();
+
+    // logs of one process come in runs, the hash is looked up once per run
+    trace::Symbol lastProcess;
+    graph::Bitmap *lastRows = nullptr;
+    for (size_t row = 0; row < shown.size(); ++row) {
+        const auto &logIndex = shown[row];
+        const auto &record = logIndex.record();
+        const auto process = logIndex.span->process != nullptr ? logIndex.span->process->name
+                                                               : trace::Symbol();
+
+        m_levels[row] = record.level;
+        m_processes[row] = process;
+        m_levelRows[static_cast<size_t>(record.level)].set(row);
+        if (record.hasError) {
+            m_errorRows.set(row);
+        }
+
+        if (lastRows == nullptr || process != lastProcess) {
+            auto iter = m_processRows.find(process);
+            if (iter == m_processRows.end()) {
+                iter = m_processRows.insert(process, graph::Bitmap(shown.size()));
             }
+            lastProcess = process;
+            lastRows = &iter.value();
         }
+        lastRows->set(row);
+    }
+}
+
+void FlatLogModel::restrictToSubtree(int row)
+{
+    if (row < 0 || row >= rowCount()) {
+        return;
+    }
+
+    const auto *span = rows()[static_cast<size_t>(row)].span;
+    if (span == m_subtreeRoot) {
+        return;
     }
 
-    std::sort(m_indexes.begin(), m_indexes.end(), [](const auto &i, const auto &j) -> bool {
-        return i.span->logs[i.logIndex].timestamp < j.span->logs[j.logIndex].timestamp;
+    // preorder numbers are per trace, the root compares with spans of its own trace only
+    const auto &traces = m_graph.data->traces;
+    const auto trace = std::find_if(traces.cbegin(), traces.cend(), [span](const auto &trace) {
+        return trace->owns(*span);
     });
+    if (trace == traces.cend()) {
+        return;
+    }
+
+    beginResetModel();
+    m_subtreeRoot = span;
+    m_subtreeTrace = trace->get();
+    filterIndexes();
     endResetModel();
+    emit notifySubtreeRootChanged();
+}
+
+void FlatLogModel::clearSubtree()
+{
+    if (m_subtreeRoot == nullptr) {
+        return;
+    }
+
+    beginResetModel();
+    m_subtreeRoot = nullptr;
+    m_subtreeTrace = nullptr;
+    filterIndexes();
+    endResetModel();
+    emit notifySubtreeRootChanged();
+}
+
+QString FlatLogModel::subtreeRoot() const
+{
+    if (m_subtreeRoot == nullptr) {
+        return {};
+    }
+
+    return m_subtreeRoot->spanID.toString();
 }
 
 QHash<int, QByteArray> FlatLogModel::roleNames() const
@@ -177,6 +522,7 @@ QHash<int, QByteArray> FlatLogModel::roleNames() const
                                         {Span, "span"},
                                         {Process, "process"},
                                         {Message, "message"},
+                                        {Summary, "summary"},
                                         {LevelColor, "levelColor"},
                                         {HasError, "hasError"}
 
@@ -190,8 +536,14 @@ FieldsModel::FieldsModel(QObject *parent)
 
 void FieldsModel::setFields(const QVariant &data)
 {
+    const auto fields = data.value<LogFields>();
+
     beginResetModel();
-    m_fields = data.value<QVector<graph::LogRecord::Field>>();
+    m_fields.clear();
+    m_fields.reserve(fields.fields.size());
+    for (const auto &field : fields.fields) {
+        m_fields.push_back({field.key.toString(), field.value.toString()});
+    }
     emit notifyFieldsChanged();
     endResetModel();
 }
@@ -222,7 +574,7 @@ QVariant FieldsModel::data(const QModelIndex &index, int role) const
     case Key:
         return m_fields[row].key;
     case Value:
-        return m_fields[row].value.toString();
+        return m_fields[row].value;
     default:
         return {};
     }
@@ -297,29 +649,9 @@ void LogLevelModel::checked(int row, bool check)
 }
 
 FilteredLogModel::FilteredLogModel(QObject *parent)
-    : QSortFilterProxyModel(parent)
-    , m_logLevel(nullptr)
+    : QAbstractProxyModel(parent)
 {}
 
-bool FilteredLogModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
-{
-    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
-    auto level = index.data(FlatLogModel::RawLevel).value<graph::LogRecord::Level>();
-    auto process = index.data(FlatLogModel::Process).toString();
-
-    bool byLevel = true;
-    if (!m_selectedLevels.isEmpty()) {
-        byLevel = m_selectedLevels.contains(level);
-    }
-
-    bool byProcess = true;
-    if (!m_selectedProcess.isEmpty()) {
-        byProcess = m_selectedProcess.contains(process);
-    }
-
-    return byLevel && byProcess;
-}
-
 LogLevelModel *FilteredLogModel::logLevel()
 {
     return m_logLevel;
@@ -350,18 +682,379 @@ void FilteredLogModel::setProcess(ProcessModel *process)
                      &FilteredLogModel::onSelectedProcess);
 }
 
-void FilteredLogModel::onSelectedLevels(const QSet<graph::LogRecord::Level> &set)
+const QString &FilteredLogModel::searchText() const
+{
+    return m_searchText;
+}
+
+void FilteredLogModel::setSearchText(const QString &text)
+{
+    if (m_searchText == text) {
+        return;
+    }
+
+    m_searchText = text;
+    emit notifySearchTextChanged();
+    search();
+}
+
+int FilteredLogModel::matchCount() const
 {
+    if (m_searching || m_searchText.size() < MinSearchLength) {
+        return 0;
+    }
+
+    return static_cast<int>(m_searchMask.count());
+}
+
+bool FilteredLogModel::searching() const
+{
+    return m_searching;
+}
+
+int FilteredLogModel::minSearchLength() const
+{
+    return MinSearchLength;
+}
+
+void FilteredLogModel::setSourceModel(QAbstractItemModel *model)
+{
+    QObject::disconnect(m_sourceAboutToBeReset);
+    QObject::disconnect(m_sourceReset);
+    QObject::disconnect(m_sourceDataChanged);
+    QObject::disconnect(m_sourceIndexed);
+
     beginResetModel();
-    m_selectedLevels = set;
+    QAbstractProxyModel::setSourceModel(model);
+    if (model != nullptr) {
+        m_sourceAboutToBeReset = QObject::connect(model,
+                                                  &QAbstractItemModel::modelAboutToBeReset,
+                                                  this,
+                                                  &FilteredLogModel::onSourceAboutToBeReset);
+        m_sourceReset = QObject::connect(model,
+                                         &QAbstractItemModel::modelReset,
+                                         this,
+                                         &FilteredLogModel::onSourceReset);
+        m_sourceDataChanged = QObject::connect(model,
+                                               &QAbstractItemModel::dataChanged,
+                                               this,
+                                               &FilteredLogModel::onSourceDataChanged);
+        if (const auto *logs = flatLogs()) {
+            m_sourceIndexed = QObject::connect(logs,
+                                               &FlatLogModel::notifySearchIndexedChanged,
+                                               this,
+                                               &FilteredLogModel::search);
+        }
+    }
+    makeLevelMask();
+    makeProcessMask();
+    clearSearchMask();
+    makeRows();
     endResetModel();
+    search();
 }
 
-void FilteredLogModel::onSelectedProcess(const QSet<QString> &set)
+QModelIndex FilteredLogModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= rowCount() || column < 0
+        || column >= columnCount()) {
+        return {};
+    }
+
+    return createIndex(row, column);
+}
+
+QModelIndex FilteredLogModel::parent(const QModelIndex &index) const
+{
+    Q_UNUSED(index)
+    return {};
+}
+
+int FilteredLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(shownCount());
+}
+
+int FilteredLogModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || sourceModel() == nullptr) {
+        return 0;
+    }
+
+    return sourceModel()->columnCount();
+}
+
+QModelIndex FilteredLogModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || sourceModel() == nullptr) {
+        return {};
+    }
+
+    return sourceModel()->index(sourceRow(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex FilteredLogModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid()) {
+        return {};
+    }
+
+    const auto row = proxyRow(sourceIndex.row());
+    if (row < 0) {
+        return {};
+    }
+
+    return createIndex(row, sourceIndex.column());
+}
+
+QVariant FilteredLogModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && sourceModel() != nullptr) {
+        return sourceModel()->headerData(section, orientation, role);
+    }
+
+    return role == Qt::DisplayRole ? QVariant(section) : QVariant();
+}
+
+QHash<int, QByteArray> FilteredLogModel::roleNames() const
+{
+    return sourceModel() != nullptr ? sourceModel()->roleNames() : QHash<int, QByteArray>();
+}
+
+const FlatLogModel *FilteredLogModel::flatLogs() const
+{
+    return qobject_cast<const FlatLogModel *>(sourceModel());
+}
+
+void FilteredLogModel::makeLevelMask()
+{
+    const auto *model = flatLogs();
+    const auto rows = model != nullptr ? static_cast<size_t>(model->rowCount()) : 0;
+    if (m_selectedLevels.isEmpty()) {
+        m_levelMask = graph::Bitmap(rows, true);
+        return;
+    }
+
+    // every row has one level, the selected ones are or-ed
+    m_levelMask = graph::Bitmap(rows);
+    for (const auto level : m_selectedLevels) {
+        m_levelMask |= model->levelRows(level);
+    }
+}
+
+void FilteredLogModel::makeProcessMask()
+{
+    const auto *model = flatLogs();
+    const auto rows = model != nullptr ? static_cast<size_t>(model->rowCount()) : 0;
+    if (m_selectedProcess.isEmpty()) {
+        m_processMask = graph::Bitmap(rows, true);
+        return;
+    }
+
+    m_processMask = graph::Bitmap(rows);
+    for (const auto process : m_selectedProcess) {
+        if (const auto *processRows = model->processRows(process)) {
+            m_processMask |= *processRows;
+        }
+    }
+}
+
+void FilteredLogModel::clearSearchMask()
+{
+    const auto *model = flatLogs();
+    const auto rows = model != nullptr ? static_cast<size_t>(model->rowCount()) : 0;
+    m_searchMask = graph::Bitmap(rows, true);
+}
+
+void FilteredLogModel::search()
+{
+    ++m_searchGeneration;
+    const auto *model = flatLogs();
+    if (model == nullptr || m_searchText.size() < MinSearchLength) {
+        setSearching(false);
+        if (m_searchMask.count() != m_searchMask.size()) {
+            clearSearchMask();
+            updateRows();
+        }
+        emit notifyMatchCountChanged();
+        return;
+    }
+
+    // rows shown now stay until the matches arrive
+    setSearching(true);
+    emit notifyMatchCountChanged();
+    auto task = model->searchTask(m_searchText);
+    if (!task) {
+        // the index is being built, its signal starts the search again
+        return;
+    }
+
+    QPointer<FilteredLogModel> proxy(this);
+    const auto generation = m_searchGeneration;
+    QThreadPool::globalInstance()->start([proxy, task = std::move(task), generation]() {
+        auto matches = std::make_shared<const std::vector<quint32>>(task());
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [proxy, matches, generation]() {
+                if (proxy && proxy->m_searchGeneration == generation) {
+                    proxy->applySearch(*matches);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void FilteredLogModel::applySearch(const std::vector<quint32> &matches)
+{
+    m_searchMask = flatLogs()->shownRows(matches);
+    updateRows();
+    setSearching(false);
+    emit notifyMatchCountChanged();
+}
+
+void FilteredLogModel::setSearching(bool searching)
+{
+    if (m_searching != searching) {
+        m_searching = searching;
+        emit notifySearchingChanged();
+    }
+}
+
+void FilteredLogModel::makeRows()
+{
+    auto accepted = m_levelMask;
+    accepted &= m_processMask;
+    accepted &= m_searchMask;
+
+    m_rows.clear();
+    m_rows.reserve(accepted.count());
+    accepted.forEach([this](size_t row) { m_rows.push_back(static_cast<int>(row)); });
+}
+
+void FilteredLogModel::updateRows()
+{
+    auto accepted = m_levelMask;
+    accepted &= m_processMask;
+    accepted &= m_searchMask;
+
+    std::vector<int> next;
+    next.reserve(accepted.count());
+    accepted.forEach([&next](size_t row) { next.push_back(static_cast<int>(row)); });
+
+    // both are increasing, every row walked is less than the stale ones left, so the shown
+    // rows stay in order between the signals
+    m_staleRows.swap(m_rows);
+    m_staleFirst = 0;
+    m_rows.clear();
+    m_rows.reserve(next.size());
+
+    size_t nextFirst = 0;
+    while (m_staleFirst < m_staleRows.size() || nextFirst < next.size()) {
+        const auto row = static_cast<int>(m_rows.size());
+        const bool staleLeft = m_staleFirst < m_staleRows.size();
+        const bool nextLeft = nextFirst < next.size();
+
+        if (staleLeft && nextLeft && m_staleRows[m_staleFirst] == next[nextFirst]) {
+            m_rows.push_back(next[nextFirst]);
+            ++m_staleFirst;
+            ++nextFirst;
+        } else if (!nextLeft || (staleLeft && m_staleRows[m_staleFirst] < next[nextFirst])) {
+            auto last = m_staleFirst;
+            while (last < m_staleRows.size()
+                   && (!nextLeft || m_staleRows[last] < next[nextFirst])) {
+                ++last;
+            }
+            beginRemoveRows(QModelIndex(), row, row + static_cast<int>(last - m_staleFirst) - 1);
+            m_staleFirst = last;
+            endRemoveRows();
+        } else {
+            auto last = nextFirst;
+            while (last < next.size() && (!staleLeft || next[last] < m_staleRows[m_staleFirst])) {
+                ++last;
+            }
+            beginInsertRows(QModelIndex(), row, row + static_cast<int>(last - nextFirst) - 1);
+            m_rows.insert(m_rows.end(),
+                          next.cbegin() + static_cast<qsizetype>(nextFirst),
+                          next.cbegin() + static_cast<qsizetype>(last));
+            nextFirst = last;
+            endInsertRows();
+        }
+    }
+
+    m_staleRows.clear();
+    m_staleFirst = 0;
+}
+
+size_t FilteredLogModel::shownCount() const
+{
+    return m_rows.size() + m_staleRows.size() - m_staleFirst;
+}
+
+int FilteredLogModel::sourceRow(int row) const
+{
+    const auto shown = static_cast<size_t>(row);
+    return shown < m_rows.size() ? m_rows[shown]
+                                 : m_staleRows[m_staleFirst + shown - m_rows.size()];
+}
+
+int FilteredLogModel::proxyRow(int source) const
+{
+    const auto walked = std::lower_bound(m_rows.cbegin(), m_rows.cend(), source);
+    if (walked != m_rows.cend()) {
+        return *walked == source ? static_cast<int>(walked - m_rows.cbegin()) : -1;
+    }
+
+    const auto staleBegin = m_staleRows.cbegin() + static_cast<qsizetype>(m_staleFirst);
+    const auto stale = std::lower_bound(staleBegin, m_staleRows.cend(), source);
+    if (stale == m_staleRows.cend() || *stale != source) {
+        return -1;
+    }
+    return static_cast<int>(m_rows.size() + static_cast<size_t>(stale - staleBegin));
+}
+
+void FilteredLogModel::onSelectedLevels(const QSet<graph::LogRecord::Level> &set)
+{
+    m_selectedLevels = set;
+    makeLevelMask();
+    updateRows();
+}
+
+void FilteredLogModel::onSelectedProcess(const QSet<trace::Symbol> &set)
 {
-    beginResetModel();
     m_selectedProcess = set;
+    makeProcessMask();
+    updateRows();
+}
+
+void FilteredLogModel::onSourceAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void FilteredLogModel::onSourceReset()
+{
+    makeLevelMask();
+    makeProcessMask();
+    clearSearchMask();
+    makeRows();
     endResetModel();
+    search();
+}
+
+void FilteredLogModel::onSourceDataChanged(const QModelIndex &topLeft,
+                                           const QModelIndex &bottomRight,
+                                           const QList<int> &roles)
+{
+    // accepted rows of the source range, they are consecutive here too
+    const auto first = std::lower_bound(m_rows.cbegin(), m_rows.cend(), topLeft.row());
+    const auto last = std::upper_bound(first, m_rows.cend(), bottomRight.row());
+    if (first == last) {
+        return;
+    }
+
+    emit dataChanged(index(static_cast<int>(first - m_rows.cbegin()), topLeft.column()),
+                     index(static_cast<int>(last - m_rows.cbegin()) - 1, bottomRight.column()),
+                     roles);
 }
 
 ProcessModel::ProcessModel(QObject *parent)
@@ -386,10 +1079,17 @@ void ProcessModel::makeRecords()
 {
     beginResetModel();
     m_records.clear();
-    for (int i = 0; i < m_graph.data->traces.size(); i++) {
-        const auto &trace = m_graph.data->traces[i];
-        for (int j = 0; j < trace->process.size(); ++j) {
-            Record rec{false, trace->process[j]->name};
+
+    QSet<trace::Symbol> names;
+    for (const auto &trace : m_graph.data->traces) {
+        for (const auto &process : trace->process) {
+            const auto name = process.name;
+            if (names.contains(name)) {
+                continue;
+            }
+
+            names.insert(name);
+            Record rec{false, name};
             m_records.emplace_back(rec);
         }
     }
@@ -421,7 +1121,7 @@ QVariant ProcessModel::data(const QModelIndex &index, int role) const
     const auto row = index.row();
     switch (role) {
     case Process:
-        return m_records[row].name;
+        return m_records[row].name.toString();
     case IsChecked:
         return m_records[row].checked;
     default:
@@ -1,17 +1,36 @@
 #pragma once
 
+#include <array>
+#include <functional>
+#include <memory>
+
+#include <QtCore/QAbstractProxyModel>
 #include <QtCore/QAbstractTableModel>
+#include <QtCore/QCache>
 #include <QtCore/QSet>
-#include <QtCore/QSortFilterProxyModel>
 #include <QtCore/QVector>
 
+#include "graph/bitmap.h"
+#include "graph/log_order.h"
+#include "graph/log_search.h"
+
 #include "trace.h"
 
 namespace components {
+//! fields of a log for the popup, the strings point into keeper and into the graph
+struct LogFields
+{
+    QVector<graph::LogRecord::Field> fields;
+    trace::SourcePtr keeper;
+    std::shared_ptr<graph::TraceGraph> graph;
+};
+
 class FlatLogModel : public QAbstractTableModel
 {
     Q_OBJECT
     Q_PROPERTY(TraceGraph graph READ getGraph WRITE setGraph NOTIFY notifyGraphChanged)
+    Q_PROPERTY(QString subtreeRoot READ subtreeRoot NOTIFY notifySubtreeRootChanged)
+    Q_PROPERTY(bool searchIndexed READ searchIndexed NOTIFY notifySearchIndexedChanged)
 
 public:
     enum Roles {
@@ -22,7 +41,8 @@ public:
         Message,
         LevelColor,
         HasError,
-        RawLevel
+        RawLevel,
+        Summary
     };
 
     explicit FlatLogModel(QObject *parent = nullptr);
@@ -38,23 +58,93 @@ public:
                         int role = Qt::DisplayRole) const override final;
     QHash<int, QByteArray> roleNames() const override;
 
+    graph::LogRecord::Level level(int row) const;
+    trace::Symbol processName(int row) const;
+
+    //! rows of the level, rowCount() bits
+    const graph::Bitmap &levelRows(graph::LogRecord::Level level) const;
+    //! rows of the process, nullptr when it has no logs
+    const graph::Bitmap *processRows(trace::Symbol process) const;
+
+    //! increasing rows of every log whose fields contain text, for any thread. Empty until
+    //! the index is built in the background, the task keeps the graph alive while it runs
+    std::function<std::vector<quint32>()> searchTask(const QString &text) const;
+    //! rows shown among the increasing rows of every log a search task returned
+    graph::Bitmap shownRows(const std::vector<quint32> &matches) const;
+    bool searchIndexed() const;
+
+    //! keep logs of the span of row and of its descendants only
+    Q_INVOKABLE void restrictToSubtree(int row);
+    Q_INVOKABLE void clearSubtree();
+    //! span ID of the subtree root, empty when logs of all spans are shown
+    QString subtreeRoot() const;
+
 signals:
 
     void notifyGraphChanged();
+    void notifySubtreeRootChanged();
+    void notifySearchIndexedChanged();
 
 private:
-    struct LogIndex
+    void orderLogs();
+    void makeIndexes(const std::shared_ptr<const std::vector<graph::LogRef>> &order);
+    void setSearchIndex(const std::shared_ptr<const graph::LogSearchIndex> &index);
+    void filterIndexes();
+    //! display strings of the rows that were shown before, chunks in flight are dropped too
+    void dropChunks();
+    //! level and process of every row, and the rows of each of them
+    void makeColumns();
+    //! logs that are shown
+    const std::vector<graph::LogRef> &rows() const;
+
+    //! display strings of ChunkSize consecutive rows, built in the background
+    struct Chunk
     {
-        graph::Span *span;
-        int logIndex;
+        std::vector<QString> times;
+        //! one line summary of the fields
+        std::vector<QString> summaries;
+        //! IDs of the spans of the chunk and the one of every row
+        std::vector<QString> spans;
+        std::vector<quint32> rowSpans;
     };
 
-    void makeIndexes();
+    static constexpr int ChunkSize = 256;
+    //! a few screens of rows around the viewport, whatever the number of logs
+    static constexpr int CachedChunks = 64;
+    static constexpr qsizetype SummaryLength = 200;
+
+    //! nullptr until the chunk of row is built, it is then requested with its neighbours
+    const Chunk *displayChunk(int row) const;
+    void requestChunk(int index) const;
+    static Chunk makeChunk(const std::vector<graph::LogRef> &logs);
+    void insertChunk(int index, Chunk &&chunk);
 
 private:
     TraceGraph m_graph;
     QVector<QString> m_headers;
-    QVector<LogIndex> m_indexes;
+    //! every log ordered by time, shared with the worker that indexes it
+    std::shared_ptr<const std::vector<graph::LogRef>> m_allIndexes;
+    std::shared_ptr<const graph::LogSearchIndex> m_searchIndex;
+    //! logs of the subtree and their rows in m_allIndexes, empty without one
+    std::vector<graph::LogRef> m_indexes;
+    std::vector<quint32> m_indexRows;
+    const graph::Span *m_subtreeRoot = nullptr;
+    //! trace of the subtree root, spans of other traces with the same ID are not in it
+    const graph::Trace *m_subtreeTrace = nullptr;
+
+    //! built once per reset, filters combine the bitmaps instead of reading every log
+    std::vector<graph::LogRecord::Level> m_levels;
+    std::vector<trace::Symbol> m_processes;
+    std::array<graph::Bitmap, static_cast<size_t>(graph::LogRecord::Level::Fatal) + 1> m_levelRows;
+    QHash<trace::Symbol, graph::Bitmap> m_processRows;
+    graph::Bitmap m_errorRows;
+
+    //! least recently used chunks are dropped, cleared whenever rows change. Roles return
+    //! shared copies of the strings, so a view keeps them when the chunk goes away
+    mutable QCache<int, Chunk> m_chunks;
+    mutable QSet<int> m_pendingChunks;
+    //! chunks requested for older rows are dropped when they arrive
+    quint64 m_chunkGeneration = 0;
 };
 
 class FieldsModel : public QAbstractListModel
@@ -78,7 +168,15 @@ signals:
     void notifyFieldsChanged();
 
 private:
-    QVector<graph::LogRecord::Field> m_fields;
+    struct Field
+    {
+        QString key;
+        QString value;
+    };
+
+private:
+    //! copied from the log, the strings it points to may go away with the graph
+    QVector<Field> m_fields;
 };
 
 class LogLevelModel : public QAbstractListModel
@@ -115,11 +213,17 @@ private:
 
 class ProcessModel;
 
-class FilteredLogModel : public QSortFilterProxyModel
+//! rows of FlatLogModel accepted by the level, process and search filters, kept as bitmaps
+class FilteredLogModel : public QAbstractProxyModel
 {
     Q_OBJECT
     Q_PROPERTY(LogLevelModel *logLevel READ logLevel WRITE setLogLevel NOTIFY notifyLogLevelChanged)
     Q_PROPERTY(ProcessModel *process READ process WRITE setProcess NOTIFY notifyProcessChanged)
+    Q_PROPERTY(
+        QString searchText READ searchText WRITE setSearchText NOTIFY notifySearchTextChanged)
+    Q_PROPERTY(int matchCount READ matchCount NOTIFY notifyMatchCountChanged)
+    Q_PROPERTY(bool searching READ searching NOTIFY notifySearchingChanged)
+    Q_PROPERTY(int minSearchLength READ minSearchLength CONSTANT)
 public:
     explicit FilteredLogModel(QObject *parent = nullptr);
 
@@ -129,24 +233,93 @@ public:
     ProcessModel *process();
     void setProcess(ProcessModel *process);
 
+    const QString &searchText() const;
+    //! shorter text than minSearchLength does not filter, longer one is searched on a worker
+    void setSearchText(const QString &text);
+    //! logs that contain the search text, whatever the other filters
+    int matchCount() const;
+    //! the search text filters, but its rows are not known yet
+    bool searching() const;
+    int minSearchLength() const;
+
+    void setSourceModel(QAbstractItemModel *model) override;
+
+    QModelIndex index(int row,
+                      int column,
+                      const QModelIndex &parent = QModelIndex()) const override final;
+    QModelIndex parent(const QModelIndex &index) const override final;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override final;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override final;
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override final;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override final;
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override final;
+    QHash<int, QByteArray> roleNames() const override;
+
 signals:
 
     void notifyLogLevelChanged();
     void notifyProcessChanged();
-
-protected:
-    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override final;
+    void notifySearchTextChanged();
+    void notifyMatchCountChanged();
+    void notifySearchingChanged();
 
 private slots:
 
     void onSelectedLevels(const QSet<graph::LogRecord::Level> &set);
-    void onSelectedProcess(const QSet<QString> &set);
+    void onSelectedProcess(const QSet<trace::Symbol> &set);
+    void onSourceAboutToBeReset();
+    void onSourceReset();
+    //! searches of the previous rows are dropped, and so are searches of an older text
+    void search();
+    void onSourceDataChanged(const QModelIndex &topLeft,
+                             const QModelIndex &bottomRight,
+                             const QList<int> &roles);
 
 private:
-    LogLevelModel *m_logLevel;
-    ProcessModel *m_process;
+    const FlatLogModel *flatLogs() const;
+    //! a toggle rebuilds the mask of its filter only, the other one is kept
+    void makeLevelMask();
+    void makeProcessMask();
+    //! every row until the search text is searched
+    void clearSearchMask();
+    void applySearch(const std::vector<quint32> &matches);
+    void setSearching(bool searching);
+    void makeRows();
+    //! rows accepted by the masks, the runs that differ from the shown ones are removed and
+    //! inserted so views keep their delegates and position
+    void updateRows();
+    //! shown rows, the walked and the stale ones while updateRows runs
+    size_t shownCount() const;
+    int sourceRow(int row) const;
+    //! -1 when the source row is not shown
+    int proxyRow(int source) const;
+
+    //! a trigram, shorter text matches most logs and would be a scan
+    static constexpr int MinSearchLength = 3;
+
+private:
+    LogLevelModel *m_logLevel = nullptr;
+    ProcessModel *m_process = nullptr;
     QSet<graph::LogRecord::Level> m_selectedLevels;
-    QSet<QString> m_selectedProcess;
+    QSet<trace::Symbol> m_selectedProcess;
+    QString m_searchText;
+    bool m_searching = false;
+    quint64 m_searchGeneration = 0;
+
+    QMetaObject::Connection m_sourceAboutToBeReset;
+    QMetaObject::Connection m_sourceReset;
+    QMetaObject::Connection m_sourceDataChanged;
+    QMetaObject::Connection m_sourceIndexed;
+    graph::Bitmap m_levelMask;
+    graph::Bitmap m_processMask;
+    graph::Bitmap m_searchMask;
+    //! accepted source rows in increasing order
+    std::vector<int> m_rows;
+    //! shown rows from m_staleFirst on that updateRows did not walk yet, they follow m_rows
+    std::vector<int> m_staleRows;
+    size_t m_staleFirst = 0;
 };
 
 class ProcessModel : public QAbstractListModel
@@ -171,13 +344,13 @@ public:
 signals:
 
     void notifyGraphChanged();
-    void selectedProcess(const QSet<QString> &set);
+    void selectedProcess(const QSet<trace::Symbol> &set);
 
 private:
     struct Record
     {
         bool checked = false;
-        QString name;
+        trace::Symbol name;
     };
 
     void makeRecords();
@@ -185,6 +358,8 @@ private:
 private:
     TraceGraph m_graph;
     QVector<Record> m_records;
-    QSet<QString> m_selectedProcess;
+    QSet<trace::Symbol> m_selectedProcess;
 };
 } // namespace components
+
+Q_DECLARE_METATYPE(components::LogFields)
@@ -1,14 +1,20 @@
+#include <cmath>
+
 #include <QtQml/QQmlEngine>
 
 #include "flat_logs.h"
 #include "helpers.h"
 #include "service_map.h"
+#include "snapshot_writer.h"
+#include "span_model.h"
+#include "trace_diff.h"
 #include "trace_downloader.h"
 
 namespace components {
 void registerTypes()
 {
     qmlRegisterType<TraceDownloader>("jaeger", 1, 0, "TraceDownloader");
+    qmlRegisterType<SnapshotWriter>("jaeger", 1, 0, "SnapshotWriter");
     qmlRegisterType<FlatLogModel>("jaeger", 1, 0, "FlatLogModel");
     qmlRegisterType<FieldsModel>("jaeger", 1, 0, "FieldsModel");
     qmlRegisterType<LogLevelModel>("jaeger", 1, 0, "LogLevelModel");
@@ -16,5 +22,24 @@ void registerTypes()
     qmlRegisterType<ProcessModel>("jaeger", 1, 0, "ProcessModel");
     qmlRegisterType<ServiceMap>("jaeger", 1, 0, "ServiceMap");
     qmlRegisterType<ServiceMapNodeItem>("jaeger", 1, 0, "ServiceMapNodeItem");
+    qmlRegisterType<SpanModel>("jaeger", 1, 0, "SpanModel");
+    qmlRegisterType<TraceDiffModel>("jaeger", 1, 0, "TraceDiffModel");
+}
+
+QString durationToString(std::chrono::microseconds duration)
+{
+    static const QVector<QString> postfix = {
+        "µs",
+        "ms",
+        "sec",
+    };
+
+    double microseconds = duration.count();
+    int count = 0;
+    while (std::abs(microseconds) > 1000) {
+        microseconds = microseconds / 1000;
+        count++;
+    }
+    return QString("%1%2").arg(QString::number(microseconds, 'f', 2)).arg(postfix.value(count, ""));
 }
 } // namespace components
\ No newline at end of file
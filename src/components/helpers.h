@@ -1,5 +1,12 @@
 #pragma once
 
+#include <chrono>
+
+#include <QtCore/QString>
+
 namespace components {
 void registerTypes();
+
+//! duration with the largest unit that keeps it above 1, e.g. "12.50ms"
+QString durationToString(std::chrono::microseconds duration);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <graphviz/cgraph.h>
 #include <graphviz/gvc.h>
 
+#include <QtCore/QThread>
 #include <QtGui/QGuiApplication>
 
 #include <QtQml/QQmlContext>
@@ -9,6 +10,9 @@
 #include <QtQuick/QSGGeometry>
 #include <QtQuick/QSGGeometryNode>
 
+#include "graph/critical_path.h"
+#include "graph/dependency_graph.h"
+
 #include "service_map.h"
 #include "span_model.h"
 
@@ -53,18 +57,24 @@ namespace components {
 
 const QString &ServiceMapNode::name() const
 {
-    return process->name;
+    return process->name.toString();
 }
 
 QStringList ServiceMapNode::operations() const
 {
-    QSet<QString> data;
+    QSet<trace::Symbol> data;
     for (const auto &edge : inEdges) {
-        for (auto span : edge.spans) {
-            data.insert(span->operationName);
+        for (const auto &row : edge.spans) {
+            data.insert(row.span->operationName);
         }
     }
-    return data.values();
+
+    QStringList operations;
+    operations.reserve(data.size());
+    for (auto operation : data) {
+        operations.push_back(operation.toString());
+    }
+    return operations;
 }
 
 bool ServiceMapNode::hasEdges() const
@@ -72,6 +82,11 @@ bool ServiceMapNode::hasEdges() const
     return !inEdges.isEmpty();
 }
 
+bool ServiceMapNode::onCriticalPath() const
+{
+    return criticalTime.count() > 0;
+}
+
 struct ServiceMapCtx
 {
     ServiceMapCtx()
@@ -150,7 +165,46 @@ void ServiceMap::setDelegate(QQmlComponent *delegate)
 {
     m_delegate = delegate;
     emit notifyDelegateChanged();
-    if (m_trace.data) {
+    rebuild();
+}
+
+bool ServiceMap::merged() const
+{
+    return m_merged;
+}
+
+void ServiceMap::setMerged(bool merged)
+{
+    if (m_merged == merged) {
+        return;
+    }
+
+    m_merged = merged;
+    emit notifyMergedChanged();
+    rebuild();
+}
+
+bool ServiceMap::groupByTags() const
+{
+    return m_groupByTags;
+}
+
+void ServiceMap::setGroupByTags(bool groupByTags)
+{
+    if (m_groupByTags == groupByTags) {
+        return;
+    }
+
+    m_groupByTags = groupByTags;
+    emit notifyGroupByTagsChanged();
+    if (m_merged) {
+        rebuild();
+    }
+}
+
+void ServiceMap::rebuild()
+{
+    if (m_trace.data && m_delegate) {
         makeServiceGraph();
         makeQuickNodes();
         computeLayout();
@@ -163,40 +217,59 @@ void ServiceMap::makeServiceGraph()
         resetGraph();
     }
 
+    if (m_merged) {
+        makeMergedGraph();
+        return;
+    }
+
     using EdgeIndex = std::tuple<graph::Process *, graph::Process *>;
 
-    for (int i = 0; i < m_trace.data->traces.size(); ++i) {
-        const auto &trace = m_trace.data->traces[i];
+    for (const auto &trace : m_trace.data->traces) {
 
         QHash<graph::Process *, int> processMap;
         processMap.reserve(trace->process.size());
 
-        for (int n = 0; n < trace->process.size(); ++n) {
+        for (auto &process : trace->process) {
             ServiceMapNode node;
-            node.process = trace->process[n].get();
+            node.process = &process;
             m_nodes.emplace_back(node);
-            processMap.insert(trace->process[n].get(), m_nodes.size() - 1);
+            processMap.insert(&process, m_nodes.size() - 1);
         }
 
+        const auto criticalPath = graph::CriticalPath::compute(*trace);
+
         QMap<EdgeIndex, int> edgesMap;
-        for (int s = 0; s < trace->spans.size(); ++s) {
-            const auto &span = trace->spans[s];
-            if (span->parent == nullptr) {
+        for (auto &span : trace->spans) {
+            SpanRow row{&span};
+            if (!criticalPath.isEmpty()) {
+                const auto index = static_cast<size_t>(&span - trace->spans.data());
+                row.criticalTime = criticalPath.contribution[index];
+            }
+            if (processMap.contains(span.process)) {
+                auto &node = m_nodes[processMap[span.process]];
+                node.criticalTime += row.criticalTime;
+                ++node.spanCount;
+            }
+
+            if (span.parent == nullptr) {
                 continue;
             }
 
-            if (span->parent->process == span->process) {
+            if (span.parent->process == span.process) {
                 continue;
             }
 
-            auto indx = std::make_tuple(span->parent->process, span->process);
+            auto indx = std::make_tuple(span.parent->process, span.process);
             if (edgesMap.contains(indx)) {
-                m_edges[edgesMap[indx]].spans.push_back(span.get());
+                auto &edge = m_edges[edgesMap[indx]];
+                edge.spans.push_back(row);
+                edge.critical = edge.critical || row.criticalTime.count() > 0;
             } else {
                 ServiceMapEdge edge;
-                edge.from = span->parent->process;
-                edge.to = span->process;
-                edge.spans.push_back(span.get());
+                edge.from = span.parent->process;
+                edge.to = span.process;
+                edge.spans.push_back(row);
+                edge.critical = row.criticalTime.count() > 0;
                 m_edges.emplace_back(edge);
                 edgesMap[indx] = m_edges.size() - 1;
             }
@@ -209,6 +282,41 @@ void ServiceMap::makeServiceGraph()
     };
 }
 
+void ServiceMap::makeMergedGraph()
+{
+    const auto grouping = m_groupByTags ? graph::DependencyGraph::Grouping::ByNameAndTags
+                                        : graph::DependencyGraph::Grouping::ByName;
+    const auto dependencies = graph::DependencyGraph::build(*m_trace.data,
+                                                            grouping,
+                                                            QThread::idealThreadCount());
+
+    m_nodes.reserve(static_cast<qsizetype>(dependencies.services.size()));
+    for (const auto &service : dependencies.services) {
+        ServiceMapNode node;
+        node.process = service.process;
+        node.criticalTime = service.criticalTime;
+        node.spanCount = service.spanCount;
+        m_nodes.push_back(node);
+    }
+
+    m_edges.reserve(static_cast<qsizetype>(dependencies.edges.size()));
+    for (const auto &dependency : dependencies.edges) {
+        auto &to = m_nodes[dependency.to];
+
+        ServiceMapEdge edge;
+        edge.from = m_nodes[dependency.from].process;
+        edge.to = to.process;
+        edge.critical = dependency.critical;
+        edge.spans.reserve(static_cast<qsizetype>(dependency.calls.size()));
+        for (const auto &call : dependency.calls) {
+            edge.spans.push_back({call.span, call.criticalTime});
+        }
+
+        to.inEdges.push_back(edge);
+        m_edges.push_back(std::move(edge));
+    }
+}
+
 void ServiceMap::resetGraph()
 {
     for (auto node : m_nodes) {
@@ -251,6 +359,7 @@ void ServiceMap::makeQuickNodes()
 
     for (auto &edge : m_edges) {
         edge.qmlObject = new EdgeItem;
+        edge.qmlObject->setColor(edge.critical ? QColor("#DF0101") : QColor("black"));
         edge.qmlObject->setZ(2);
         edge.qmlObject->setParentItem(this);
     }
@@ -342,7 +451,7 @@ QSGNode *EdgeItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
         m_arrowNode->setGeometry(geometry);
         m_arrowNode->setFlag(QSGNode::OwnsGeometry);
         auto *material = new QSGFlatColorMaterial;
-        material->setColor(QColor("black"));
+        material->setColor(m_color);
         m_arrowNode->setMaterial(material);
         m_arrowNode->setFlag(QSGNode::OwnsMaterial);
         geometry->allocate(3);
@@ -360,7 +469,7 @@ QSGNode *EdgeItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
         node->setGeometry(geometry);
         node->setFlag(QSGNode::OwnsGeometry);
         auto *material = new QSGFlatColorMaterial;
-        material->setColor(QColor("black"));
+        material->setColor(m_color);
         node->setMaterial(material);
         node->setFlag(QSGNode::OwnsMaterial);
 
@@ -398,6 +507,12 @@ void EdgeItem::setPoints(const QVector<QPointF> &points)
     update();
 }
 
+void EdgeItem::setColor(const QColor &color)
+{
+    m_color = color;
+    update();
+}
+
 ServiceMapNodeItem::ServiceMapNodeItem(QObject *parent)
     : QObject(parent)
     , m_process(nullptr)
@@ -409,7 +524,7 @@ void ServiceMapNodeItem::setNode(const ServiceMapNode &node)
 {
     m_process = node.process;
     notify();
-    QVector<graph::Span *> spans;
+    QVector<SpanRow> spans;
     for (const auto &edge : node.inEdges) {
         spans.append(edge.spans);
     }
@@ -421,7 +536,7 @@ void ServiceMapNodeItem::setNode(const ServiceMapNode &node)
 QString ServiceMapNodeItem::processName() const
 {
     if (m_process) {
-        return m_process->name;
+        return m_process->name.toString();
     }
 
     return {};
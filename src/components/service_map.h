@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QtGui/QColor>
 #include <QtQuick/QQuickItem>
 #include <QtQuick/QSGGeometryNode>
 
@@ -20,10 +21,16 @@ struct ServiceMapNode
     Q_PROPERTY(QString name READ name)
     Q_PROPERTY(QStringList operations READ operations)
     Q_PROPERTY(bool hasEdges READ hasEdges)
+    Q_PROPERTY(bool onCriticalPath READ onCriticalPath)
+    Q_PROPERTY(quint64 spanCount MEMBER spanCount)
 
 public:
     QVector<ServiceMapEdge> inEdges;
+    //! first process of the service when traces are merged
     graph::Process *process = nullptr;
+    quint64 spanCount = 0;
+    //! time spans of the process spend on the critical path of the trace
+    std::chrono::microseconds criticalTime{0};
     QQuickItem *qmlObject = nullptr;
     Agnode_t *gvNode = nullptr;
 
@@ -31,6 +38,7 @@ public:
     const QString &name() const;
     QStringList operations() const;
     bool hasEdges() const;
+    bool onCriticalPath() const;
 };
 
 struct ServiceMapEdge
@@ -39,7 +47,9 @@ struct ServiceMapEdge
 public:
     graph::Process *from = nullptr;
     graph::Process *to = nullptr;
-    QVector<graph::Span *> spans;
+    QVector<SpanRow> spans;
+    //! a span of the edge is on the critical path
+    bool critical = false;
     EdgeItem *qmlObject = nullptr;
     Agedge_t *gvEdge = nullptr;
 };
@@ -53,9 +63,11 @@ public:
     QSGNode *updatePaintNode(QSGNode *, UpdatePaintNodeData *) override;
 
     void setPoints(const QVector<QPointF> &points);
+    void setColor(const QColor &color);
 
 private:
     QVector<QPointF> m_points;
+    QColor m_color = Qt::black;
     QSGGeometryNode *m_arrowNode;
 };
 
@@ -66,6 +78,9 @@ class ServiceMap : public QQuickItem
     Q_OBJECT
     Q_PROPERTY(TraceGraph graph READ getGraph WRITE setGraph NOTIFY notifyGraphChanged)
     Q_PROPERTY(QQmlComponent *delegate READ delegate WRITE setDelegate NOTIFY notifyDelegateChanged)
+    Q_PROPERTY(bool merged READ merged WRITE setMerged NOTIFY notifyMergedChanged)
+    Q_PROPERTY(
+        bool groupByTags READ groupByTags WRITE setGroupByTags NOTIFY notifyGroupByTagsChanged)
 public:
     static constexpr qreal DPI = 72.0; //https://graphviz.org/doc/info/attrs.html
 
@@ -78,13 +93,25 @@ public:
     QQmlComponent *delegate() const;
     void setDelegate(QQmlComponent *delegate);
 
+    //! one node per service of all traces instead of one per process of every trace
+    bool merged() const;
+    void setMerged(bool merged);
+
+    //! merged processes of a service must have the same tags
+    bool groupByTags() const;
+    void setGroupByTags(bool groupByTags);
+
 signals:
 
     void notifyGraphChanged();
     void notifyDelegateChanged();
+    void notifyMergedChanged();
+    void notifyGroupByTagsChanged();
 
 private:
+    void rebuild();
     void makeServiceGraph();
+    void makeMergedGraph();
     void makeQuickNodes();
     void computeLayout();
     void resetGraph();
@@ -93,6 +120,8 @@ private:
     std::unique_ptr<ServiceMapCtx> m_ctx;
     TraceGraph m_trace;
     QQmlComponent *m_delegate;
+    bool m_merged = false;
+    bool m_groupByTags = false;
 
     QVector<ServiceMapNode> m_nodes;
     QVector<ServiceMapEdge> m_edges;
@@ -0,0 +1,28 @@
+#include "graph/snapshot.h"
+
+#include "snapshot_writer.h"
+
+namespace components {
+
+SnapshotWriter::SnapshotWriter(QObject *parent)
+    : QObject(parent)
+{}
+
+void SnapshotWriter::saveSnapshot(const components::TraceGraph &traceGraph, const QUrl &fileUrl)
+{
+    if (!traceGraph.data) {
+        return;
+    }
+
+    const auto fileName = fileUrl.isLocalFile() ? fileUrl.toLocalFile() : fileUrl.toString();
+
+    graph::SnapshotError snapshotError;
+    if (!graph::Snapshot::save(*traceGraph.data, fileName, &snapshotError)) {
+        emit errorSnapshot(snapshotError.errorString());
+        return;
+    }
+
+    emit snapshotSaved(fileName);
+}
+
+} // namespace components
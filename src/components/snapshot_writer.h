@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+
+#include "trace.h"
+
+namespace components {
+
+//! saves a trace graph as a binary snapshot, see graph::Snapshot
+class SnapshotWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SnapshotWriter(QObject *parent = nullptr);
+
+    Q_INVOKABLE void saveSnapshot(const components::TraceGraph &traceGraph, const QUrl &fileUrl);
+
+signals:
+
+    void errorSnapshot(const QString &message);
+    void snapshotSaved(const QString &fileName);
+};
+
+} // namespace components
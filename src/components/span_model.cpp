@@ -1,46 +1,157 @@
 #include <algorithm>
 
+#include "helpers.h"
 #include "span_model.h"
 
-namespace {
-QString durationToString(std::chrono::microseconds duration)
-{
-    static const QVector<QString> postfix = {
-        "µs",
-        "ms",
-        "sec",
-    };
-
-    double microseconds = duration.count();
-    int count = 0;
-    while (microseconds > 1000) {
-        microseconds = microseconds / 1000;
-        count++;
-    }
-    return QString("%1%2").arg(QString::number(microseconds, 'f', 2)).arg(postfix.value(count, ""));
-}
-
-} // namespace
 namespace components {
 
 SpanModel::SpanModel(QObject *parent)
     : QAbstractListModel(parent)
 {}
 
-void SpanModel::setSpans(QVector<graph::Span *> &&spans)
+void SpanModel::setSpans(QVector<SpanRow> &&spans)
 {
     beginResetModel();
     m_spans.swap(spans);
-    std::sort(m_spans.begin(), m_spans.end(), [](graph::Span *a, graph::Span *b) {
-        return a->startTime < b->startTime;
+    std::sort(m_spans.begin(), m_spans.end(), [](const SpanRow &a, const SpanRow &b) {
+        return a.span->startTime < b.span->startTime;
     });
+    makeGroups();
+    endResetModel();
+}
+
+void SpanModel::makeGroups()
+{
+    m_groups.clear();
+
+    std::vector<graph::SpanGroup> groups;
+    if (m_collapsed) {
+        std::vector<const graph::Span *> spans;
+        spans.reserve(static_cast<size_t>(m_spans.size()));
+        for (const auto &row : m_spans) {
+            spans.push_back(row.span);
+        }
+        groups = graph::SpanGroup::collapse(spans);
+    } else {
+        groups.reserve(static_cast<size_t>(m_spans.size()));
+        for (qsizetype i = 0; i < m_spans.size(); ++i) {
+            const auto duration = m_spans[i].span->duration;
+            groups.push_back({static_cast<size_t>(i), 1, duration, duration, duration});
+        }
+    }
+
+    m_groups.reserve(groups.size());
+    for (const auto &group : groups) {
+        std::chrono::microseconds criticalTime(0);
+        for (size_t i = group.first; i < group.first + group.count; ++i) {
+            criticalTime += m_spans[static_cast<qsizetype>(i)].criticalTime;
+        }
+        m_groups.push_back({group, criticalTime});
+    }
+}
+
+const TraceGraph &SpanModel::getGraph() const
+{
+    return m_graph;
+}
+
+void SpanModel::setGraph(const TraceGraph &data)
+{
+    m_graph = data;
+    emit notifyGraphChanged();
+    makeLatencyRows();
+}
+
+bool SpanModel::aggregated() const
+{
+    return m_aggregated;
+}
+
+void SpanModel::setAggregated(bool aggregated)
+{
+    if (m_aggregated == aggregated) {
+        return;
+    }
+
+    beginResetModel();
+    m_aggregated = aggregated;
+    endResetModel();
+    emit notifyAggregatedChanged();
+}
+
+const QString &SpanModel::service() const
+{
+    return m_service;
+}
+
+void SpanModel::setService(const QString &service)
+{
+    if (m_service == service) {
+        return;
+    }
+
+    m_service = service;
+    emit notifyServiceChanged();
+    makeLatencyRows();
+}
+
+bool SpanModel::collapsed() const
+{
+    return m_collapsed;
+}
+
+void SpanModel::setCollapsed(bool collapsed)
+{
+    if (m_collapsed == collapsed) {
+        return;
+    }
+
+    beginResetModel();
+    m_collapsed = collapsed;
+    makeGroups();
     endResetModel();
+    emit notifyCollapsedChanged();
+}
+
+void SpanModel::makeLatencyRows()
+{
+    if (m_aggregated) {
+        beginResetModel();
+    }
+
+    m_latency.clear();
+    if (m_graph.data != nullptr) {
+        const auto service = trace::Symbol::intern(m_service);
+        const auto &histograms = m_graph.data->latency.histograms();
+        for (auto iter = histograms.cbegin(); iter != histograms.cend(); ++iter) {
+            if (!m_service.isEmpty() && iter.key().service != service) {
+                continue;
+            }
+
+            const auto &histogram = iter.value();
+            m_latency.push_back({iter.key().service,
+                                 iter.key().operation,
+                                 histogram.count(),
+                                 histogram.percentile(0.5),
+                                 histogram.percentile(0.95),
+                                 histogram.percentile(0.99)});
+        }
+    }
+
+    // slowest operations first
+    std::sort(m_latency.begin(), m_latency.end(), [](const auto &a, const auto &b) {
+        return a.p99 > b.p99;
+    });
+
+    if (m_aggregated) {
+        endResetModel();
+    }
 }
 
 int SpanModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return m_spans.size();
+    return m_aggregated ? m_latency.size() : static_cast<int>(m_groups.size());
 }
 
 QVariant SpanModel::data(const QModelIndex &index, int role) const
@@ -48,18 +159,53 @@ QVariant SpanModel::data(const QModelIndex &index, int role) const
     if (!index.isValid()) {
         return {};
     }
-    if (index.row() >= m_spans.size()) {
+    if (index.row() >= rowCount()) {
         return {};
     }
 
-    const auto row = index.row();
+    if (m_aggregated) {
+        const auto &row = m_latency[index.row()];
+        switch (role) {
+        case Service:
+            return row.service.toString();
+        case OperationName:
+            return row.operation.toString();
+        case Count:
+            return row.count;
+        case Duration:
+        case P50:
+            return durationToString(row.p50);
+        case P95:
+            return durationToString(row.p95);
+        case P99:
+            return durationToString(row.p99);
+        default:
+            return {};
+        }
+    }
+
+    const auto &row = m_groups[static_cast<size_t>(index.row())];
+    const auto &group = row.group;
+    const auto *span = m_spans[static_cast<qsizetype>(group.first)].span;
     switch (role) {
     case SpanID:
-        return m_spans[row]->spanID;
+        return span->spanID.toString();
     case OperationName:
-        return m_spans[row]->operationName;
+        return span->operationName.toString();
     case Duration:
-        return durationToString(m_spans[row]->duration);
+        return durationToString(group.count > 1 ? group.averageDuration() : span->duration);
+    case CriticalTime:
+        return durationToString(row.criticalTime);
+    case OnCriticalPath:
+        return row.criticalTime.count() > 0;
+    case Count:
+        return group.count;
+    case MinDuration:
+        return durationToString(group.minDuration);
+    case AvgDuration:
+        return durationToString(group.averageDuration());
+    case MaxDuration:
+        return durationToString(group.maxDuration);
     default:
         return {};
     }
@@ -69,7 +215,17 @@ QHash<int, QByteArray> SpanModel::roleNames() const
 {
     static QHash<int, QByteArray> roles{{SpanID, "spanID"},
                                         {OperationName, "operationName"},
-                                        {Duration, "duration"}};
+                                        {Duration, "duration"},
+                                        {CriticalTime, "criticalTime"},
+                                        {OnCriticalPath, "onCriticalPath"},
+                                        {Service, "service"},
+                                        {Count, "count"},
+                                        {P50, "p50"},
+                                        {P95, "p95"},
+                                        {P99, "p99"},
+                                        {MinDuration, "minDuration"},
+                                        {AvgDuration, "avgDuration"},
+                                        {MaxDuration, "maxDuration"}};
     return roles;
 }
 
@@ -1,24 +1,105 @@
 #pragma once
 
+#include <chrono>
+
 #include <QtCore/QAbstractListModel>
 
 #include "graph/span.h"
+#include "graph/span_group.h"
+
+#include "trace.h"
 
 namespace components {
+struct SpanRow
+{
+    graph::Span *span = nullptr;
+    //! part of the span on the critical path of its trace
+    std::chrono::microseconds criticalTime{0};
+};
+
+//! spans given by setSpans, or latency percentiles of the graph in aggregated mode
+//! runs of sibling spans of the same shape are one row while collapsed
 class SpanModel : public QAbstractListModel
 {
     Q_OBJECT
+    Q_PROPERTY(TraceGraph graph READ getGraph WRITE setGraph NOTIFY notifyGraphChanged)
+    Q_PROPERTY(bool aggregated READ aggregated WRITE setAggregated NOTIFY notifyAggregatedChanged)
+    Q_PROPERTY(QString service READ service WRITE setService NOTIFY notifyServiceChanged)
+    Q_PROPERTY(bool collapsed READ collapsed WRITE setCollapsed NOTIFY notifyCollapsedChanged)
+
 public:
-    enum Roles { SpanID = Qt::UserRole + 1, OperationName, Duration };
+    enum Roles {
+        SpanID = Qt::UserRole + 1,
+        OperationName,
+        Duration,
+        CriticalTime,
+        OnCriticalPath,
+        Service,
+        Count,
+        P50,
+        P95,
+        P99,
+        MinDuration,
+        AvgDuration,
+        MaxDuration
+    };
 
     SpanModel(QObject *parent = nullptr);
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
-    void setSpans(QVector<graph::Span *> &&spans);
+    void setSpans(QVector<SpanRow> &&spans);
+
+    const TraceGraph &getGraph() const;
+    void setGraph(const TraceGraph &data);
+
+    bool aggregated() const;
+    void setAggregated(bool aggregated);
+
+    //! aggregated rows of one service, all of them when empty
+    const QString &service() const;
+    void setService(const QString &service);
+
+    bool collapsed() const;
+    void setCollapsed(bool collapsed);
+
+signals:
+
+    void notifyGraphChanged();
+    void notifyAggregatedChanged();
+    void notifyServiceChanged();
+    void notifyCollapsedChanged();
+
+private:
+    struct LatencyRow
+    {
+        trace::Symbol service;
+        trace::Symbol operation;
+        quint64 count;
+        std::chrono::microseconds p50;
+        std::chrono::microseconds p95;
+        std::chrono::microseconds p99;
+    };
+
+    struct GroupRow
+    {
+        graph::SpanGroup group;
+        std::chrono::microseconds criticalTime;
+    };
+
+    void makeLatencyRows();
+    void makeGroups();
 
 private:
-    QVector<graph::Span *> m_spans;
+    QVector<SpanRow> m_spans;
+    //! one per span unless collapsed
+    std::vector<GroupRow> m_groups;
+    bool m_collapsed = true;
+
+    TraceGraph m_graph;
+    bool m_aggregated = false;
+    QString m_service;
+    QVector<LatencyRow> m_latency;
 };
 } // namespace components
@@ -6,10 +6,10 @@ TagModel::TagModel(QObject *parent)
     : QAbstractListModel(parent)
 {}
 
-void TagModel::setTags(const graph::Tags &tags)
+void TagModel::setTags(graph::Range<const graph::Tag> tags)
 {
     beginResetModel();
-    m_tags = tags;
+    m_tags = graph::Tags(tags.begin(), tags.end());
     endResetModel();
 }
 
@@ -32,9 +32,9 @@ QVariant TagModel::data(const QModelIndex &index, int role) const
     const auto row = index.row();
     switch (role) {
     case Key:
-        return m_tags[row].key;
+        return m_tags[row].key.toString();
     case Value:
-        return m_tags[row].value;
+        return m_tags[row].value.toString();
     default:
         return {};
     }
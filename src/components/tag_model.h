@@ -2,6 +2,7 @@
 
 #include <QtCore/QAbstractListModel>
 
+#include "graph/range.h"
 #include "graph/tag.h"
 
 namespace components {
@@ -17,7 +18,7 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
-    void setTags(const graph::Tags &tags);
+    void setTags(graph::Range<const graph::Tag> tags);
 
 private:
     graph::Tags m_tags;
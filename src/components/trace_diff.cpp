@@ -0,0 +1,159 @@
+#include "graph/process.h"
+
+#include "helpers.h"
+#include "trace_diff.h"
+
+namespace components {
+
+TraceDiffModel::TraceDiffModel(QObject *parent)
+    : QAbstractListModel(parent)
+{}
+
+const TraceGraph &TraceDiffModel::getGraph() const
+{
+    return m_graph;
+}
+
+void TraceDiffModel::setGraph(const TraceGraph &data)
+{
+    m_graph = data;
+    emit notifyGraphChanged();
+    makeDiff();
+}
+
+int TraceDiffModel::traceCount() const
+{
+    return m_graph.data != nullptr ? static_cast<int>(m_graph.data->traces.size()) : 0;
+}
+
+int TraceDiffModel::leftTrace() const
+{
+    return m_leftTrace;
+}
+
+void TraceDiffModel::setLeftTrace(int index)
+{
+    if (m_leftTrace == index) {
+        return;
+    }
+
+    m_leftTrace = index;
+    emit notifyLeftTraceChanged();
+    makeDiff();
+}
+
+int TraceDiffModel::rightTrace() const
+{
+    return m_rightTrace;
+}
+
+void TraceDiffModel::setRightTrace(int index)
+{
+    if (m_rightTrace == index) {
+        return;
+    }
+
+    m_rightTrace = index;
+    emit notifyRightTraceChanged();
+    makeDiff();
+}
+
+int TraceDiffModel::addedSpans() const
+{
+    return static_cast<int>(m_diff.addedSpans);
+}
+
+int TraceDiffModel::removedSpans() const
+{
+    return static_cast<int>(m_diff.removedSpans);
+}
+
+void TraceDiffModel::makeDiff()
+{
+    beginResetModel();
+    m_diff = graph::TraceDiff();
+
+    const auto count = traceCount();
+    if (m_leftTrace >= 0 && m_leftTrace < count && m_rightTrace >= 0 && m_rightTrace < count) {
+        const auto &left = m_graph.data->traces[static_cast<size_t>(m_leftTrace)];
+        const auto &right = m_graph.data->traces[static_cast<size_t>(m_rightTrace)];
+        if (left && right) {
+            m_diff = graph::TraceDiff::compute(*left, *right);
+        }
+    }
+
+    endResetModel();
+    emit notifyDiffChanged();
+}
+
+int TraceDiffModel::rowCount(const QModelIndex &) const
+{
+    return static_cast<int>(m_diff.nodes.size());
+}
+
+QVariant TraceDiffModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return {};
+    }
+    if (index.row() >= rowCount()) {
+        return {};
+    }
+
+    using NodeKind = graph::TraceDiff::Node::Kind;
+
+    const auto &node = m_diff.nodes[static_cast<size_t>(index.row())];
+    const auto *span = node.left != nullptr ? node.left : node.right;
+
+    switch (role) {
+    case Depth:
+        return node.depth;
+    case Kind:
+        switch (node.kind) {
+        case NodeKind::Matched:
+            return QStringLiteral("matched");
+        case NodeKind::Added:
+            return QStringLiteral("added");
+        case NodeKind::Removed:
+            return QStringLiteral("removed");
+        }
+        return {};
+    case Service:
+        return span->process != nullptr ? span->process->name.toString() : QString();
+    case OperationName:
+        return span->operationName.toString();
+    case LeftDuration:
+        return node.left != nullptr ? durationToString(node.left->duration) : QString();
+    case RightDuration:
+        return node.right != nullptr ? durationToString(node.right->duration) : QString();
+    case Delta: {
+        if (node.kind != NodeKind::Matched) {
+            return QString();
+        }
+        const auto delta = node.delta();
+        return (delta.count() > 0 ? QStringLiteral("+") : QString()) + durationToString(delta);
+    }
+    case Slower:
+        return node.delta().count() > 0;
+    case SubtreeSize:
+        return span->descendantCount + 1;
+    }
+
+    return {};
+}
+
+QHash<int, QByteArray> TraceDiffModel::roleNames() const
+{
+    static QHash<int, QByteArray> roles{{Depth, "depth"},
+                                        {Kind, "kind"},
+                                        {Service, "service"},
+                                        {OperationName, "operationName"},
+                                        {LeftDuration, "leftDuration"},
+                                        {RightDuration, "rightDuration"},
+                                        {Delta, "delta"},
+                                        {Slower, "slower"},
+                                        {SubtreeSize, "subtreeSize"}};
+    return roles;
+}
+
+} // namespace components
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QtCore/QAbstractListModel>
+
+#include "graph/trace_diff.h"
+
+#include "trace.h"
+
+namespace components {
+
+//! merged tree of two traces of the graph in preorder, see graph::TraceDiff
+class TraceDiffModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(TraceGraph graph READ getGraph WRITE setGraph NOTIFY notifyGraphChanged)
+    Q_PROPERTY(int traceCount READ traceCount NOTIFY notifyGraphChanged)
+    Q_PROPERTY(int leftTrace READ leftTrace WRITE setLeftTrace NOTIFY notifyLeftTraceChanged)
+    Q_PROPERTY(int rightTrace READ rightTrace WRITE setRightTrace NOTIFY notifyRightTraceChanged)
+    Q_PROPERTY(int addedSpans READ addedSpans NOTIFY notifyDiffChanged)
+    Q_PROPERTY(int removedSpans READ removedSpans NOTIFY notifyDiffChanged)
+
+public:
+    enum Roles {
+        Depth = Qt::UserRole + 1,
+        Kind,
+        Service,
+        OperationName,
+        LeftDuration,
+        RightDuration,
+        Delta,
+        Slower,
+        SubtreeSize
+    };
+
+    explicit TraceDiffModel(QObject *parent = nullptr);
+
+    const TraceGraph &getGraph() const;
+    void setGraph(const TraceGraph &data);
+
+    int traceCount() const;
+
+    int leftTrace() const;
+    void setLeftTrace(int index);
+
+    int rightTrace() const;
+    void setRightTrace(int index);
+
+    int addedSpans() const;
+    int removedSpans() const;
+
+    int rowCount(const QModelIndex & = QModelIndex()) const override final;
+    QVariant data(const QModelIndex &index, int role) const override final;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+
+    void notifyGraphChanged();
+    void notifyLeftTraceChanged();
+    void notifyRightTraceChanged();
+    void notifyDiffChanged();
+
+private:
+    void makeDiff();
+
+private:
+    TraceGraph m_graph;
+    int m_leftTrace = 0;
+    int m_rightTrace = 1;
+    graph::TraceDiff m_diff;
+};
+
+} // namespace components
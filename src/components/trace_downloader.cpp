@@ -1,6 +1,10 @@
+#include <algorithm>
+
+#include <QtCore/QThread>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkReply>
 
+#include "graph/snapshot.h"
 #include "graph/trace.h"
 
 #include "trace_downloader.h"
@@ -10,6 +14,7 @@ namespace components {
 TraceDownloader::TraceDownloader(QObject *parent)
     : QObject(parent)
     , m_manager(new QNetworkAccessManager(this))
+    , m_threadCount(QThread::idealThreadCount())
 {
     QObject::connect(m_manager,
                      &QNetworkAccessManager::finished,
@@ -19,28 +24,101 @@ TraceDownloader::TraceDownloader(QObject *parent)
 
 void TraceDownloader::download(const QString &url)
 {
-    m_manager->get(QNetworkRequest(url));
+    auto reply = m_manager->get(QNetworkRequest(url));
+    auto builder = std::make_shared<graph::TraceGraphBuilder>(m_threadCount);
+    m_builders.insert(reply, builder);
+
+    QObject::connect(reply, &QNetworkReply::readyRead, this, [reply, builder]() {
+        builder->append(reply->readAll());
+    });
+}
+
+void TraceDownloader::open(const QUrl &fileUrl)
+{
+    const auto fileName = fileUrl.isLocalFile() ? fileUrl.toLocalFile() : fileUrl.toString();
+
+    QString errorString;
+    const auto source = trace::Source::mapFile(fileName, &errorString);
+    if (!source) {
+        qWarning() << "failed open trace" << fileName << errorString;
+        emit errorDownload(errorString);
+        return;
+    }
+
+    if (!graph::Snapshot::isSnapshot(source->data())) {
+        parse(source, fileName);
+        return;
+    }
+
+    graph::SnapshotError snapshotError;
+    auto traceGraph = graph::Snapshot::load(source, &snapshotError, m_threadCount);
+    if (snapshotError.error != graph::SnapshotError::Error::NoError) {
+        qWarning() << "failed load snapshot" << fileName;
+        emit errorDownload(snapshotError.errorString());
+        return;
+    }
+
+    components::TraceGraph result;
+    result.data = traceGraph;
+    emit downloaded(result);
+}
+
+int TraceDownloader::threadCount() const
+{
+    return m_threadCount;
+}
+
+void TraceDownloader::setThreadCount(int count)
+{
+    count = std::max(count, 1);
+    if (m_threadCount == count) {
+        return;
+    }
+
+    m_threadCount = count;
+    emit notifyThreadCountChanged();
 }
 
 void TraceDownloader::onFinished(QNetworkReply *reply)
 {
     reply->deleteLater();
+    const auto builder = m_builders.take(reply);
     if (reply->error() != QNetworkReply::NoError) {
         qWarning() << "failed download trace" << reply->url() << reply->errorString();
         emit errorDownload(reply->errorString());
         return;
     }
 
-    auto data = reply->readAll();
+    if (!builder) {
+        parse(trace::Source::fromData(reply->readAll()), reply->url().toString());
+        return;
+    }
+
+    builder->append(reply->readAll());
+
     trace::TraceParseError parseError;
-    auto traceDoc = trace::TraceDocument::parseDocument(data, &parseError);
+    auto traceGraph = builder->finish(&parseError);
     if (parseError.error != trace::TraceParseError::ParseError::NoError) {
         qWarning() << "failed parse trace" << reply->url();
         emit errorDownload(parseError.errorString());
         return;
     }
 
-    auto traceGraph = graph::TraceGraph::makeGraph(traceDoc);
+    components::TraceGraph result;
+    result.data = traceGraph;
+    emit downloaded(result);
+}
+
+void TraceDownloader::parse(const trace::SourcePtr &source, const QString &origin)
+{
+    trace::TraceParseError parseError;
+    auto traceGraph = graph::TraceGraph::parseGraph(source, &parseError, m_threadCount);
+    if (parseError.error != trace::TraceParseError::ParseError::NoError) {
+        qWarning() << "failed parse trace" << origin;
+        emit errorDownload(parseError.errorString());
+        return;
+    }
+
     components::TraceGraph result;
     result.data = traceGraph;
     emit downloaded(result);
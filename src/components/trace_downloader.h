@@ -1,24 +1,44 @@
 #pragma once
 
+#include <memory>
+
+#include <QtCore/QHash>
 #include <QtCore/QObject>
+#include <QtCore/QUrl>
+
+#include "trace/source.h"
 
 #include "trace.h"
 
 class QNetworkReply;
 class QNetworkAccessManager;
 
+namespace graph {
+class TraceGraphBuilder;
+}
+
 namespace components {
 
 class TraceDownloader : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(
+        int threadCount READ threadCount WRITE setThreadCount NOTIFY notifyThreadCountChanged)
 public:
     explicit TraceDownloader(QObject *parent = nullptr);
 
+    //! traces are parsed while the rest of the reply is still downloading
     Q_INVOKABLE void download(const QString &url);
+    //! map a local Jaeger JSON export or snapshot instead of reading it into memory
+    Q_INVOKABLE void open(const QUrl &fileUrl);
+
+    int threadCount() const;
+    void setThreadCount(int count);
 
 signals:
 
+    void notifyThreadCountChanged();
+
     void errorDownload(const QString &message);
     void downloaded(TraceGraph traceGraph);
 
@@ -26,8 +46,13 @@ private slots:
 
     void onFinished(QNetworkReply *reply);
 
+private:
+    void parse(const trace::SourcePtr &source, const QString &origin);
+
 private:
     QNetworkAccessManager *m_manager;
+    QHash<QNetworkReply *, std::shared_ptr<graph::TraceGraphBuilder>> m_builders;
+    int m_threadCount;
 };
 
 } // namespace components
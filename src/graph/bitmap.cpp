@@ -0,0 +1,40 @@
+#include "bitmap.h"
+
+namespace graph {
+
+Bitmap::Bitmap(size_t size, bool value)
+    : m_words((size + 63) / 64, value ? ~quint64(0) : 0)
+    , m_size(size)
+{
+    // bits past the size stay clear, count and forEach rely on it
+    if (value && size % 64 != 0) {
+        m_words.back() = (quint64(1) << (size % 64)) - 1;
+    }
+}
+
+size_t Bitmap::count() const noexcept
+{
+    size_t bits = 0;
+    for (const auto word : m_words) {
+        bits += static_cast<size_t>(qPopulationCount(word));
+    }
+    return bits;
+}
+
+Bitmap &Bitmap::operator|=(const Bitmap &other) noexcept
+{
+    for (size_t w = 0; w < m_words.size(); ++w) {
+        m_words[w] |= other.m_words[w];
+    }
+    return *this;
+}
+
+Bitmap &Bitmap::operator&=(const Bitmap &other) noexcept
+{
+    for (size_t w = 0; w < m_words.size(); ++w) {
+        m_words[w] &= other.m_words[w];
+    }
+    return *this;
+}
+
+} // namespace graph
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include <QtCore/QtAlgorithms>
+
+namespace graph {
+
+//! fixed size set of row indexes, combined a word of 64 rows at a time
+class Bitmap
+{
+public:
+    Bitmap() = default;
+    explicit Bitmap(size_t size, bool value = false);
+
+    size_t size() const noexcept { return m_size; }
+    //! number of set bits
+    size_t count() const noexcept;
+
+    bool test(size_t index) const noexcept { return (m_words[index / 64] >> (index % 64)) & 1; }
+    void set(size_t index) noexcept { m_words[index / 64] |= quint64(1) << (index % 64); }
+
+    //! both bitmaps have the same size
+    Bitmap &operator|=(const Bitmap &other) noexcept;
+    Bitmap &operator&=(const Bitmap &other) noexcept;
+
+    //! func(index) for every set bit in increasing order
+    template<typename Func>
+    void forEach(Func &&func) const
+    {
+        for (size_t w = 0; w < m_words.size(); ++w) {
+            for (auto word = m_words[w]; word != 0; word &= word - 1) {
+                func(w * 64 + qCountTrailingZeroBits(word));
+            }
+        }
+    }
+
+private:
+    std::vector<quint64> m_words;
+    size_t m_size = 0;
+};
+
+} // namespace graph
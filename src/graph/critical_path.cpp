@@ -0,0 +1,108 @@
+#include <algorithm>
+
+#include "critical_path.h"
+#include "trace.h"
+
+namespace graph {
+
+CriticalPath CriticalPath::compute(const Trace &trace)
+{
+    CriticalPath path;
+    if (trace.root == nullptr || trace.spans.empty()) {
+        return path;
+    }
+
+    const auto spanCount = trace.spans.size();
+    const auto *spans = trace.spans.data();
+    auto indexOf = [spans](const Span *span) { return static_cast<size_t>(span - spans); };
+
+    path.contribution.assign(spanCount, std::chrono::microseconds::zero());
+
+    // bounds of every span reachable from the root, clamped to its parent
+    std::vector<TimePoint> begin(spanCount);
+    std::vector<TimePoint> end(spanCount);
+    std::vector<const Span *> stack;
+
+    const auto rootIndex = indexOf(trace.root);
+    begin[rootIndex] = trace.root->startTime;
+    end[rootIndex] = trace.root->startTime + trace.root->duration;
+    stack.push_back(trace.root);
+    while (!stack.empty()) {
+        const auto *span = stack.back();
+        stack.pop_back();
+
+        const auto parentBegin = begin[indexOf(span)];
+        const auto parentEnd = end[indexOf(span)];
+        for (const auto *child : span->children) {
+            const auto i = indexOf(child);
+            begin[i] = std::clamp(child->startTime, parentBegin, parentEnd);
+            end[i] = std::clamp(child->startTime + child->duration, begin[i], parentEnd);
+            stack.push_back(child);
+        }
+    }
+
+    // children of every span from the last finished to the first one
+    std::vector<const Span *> order(trace.children.cbegin(), trace.children.cend());
+    auto childrenOf = [&](const Span *span) {
+        const auto first = static_cast<size_t>(span->children.begin() - trace.children.data());
+        return std::make_pair(order.begin() + first,
+                              order.begin() + first + span->children.size());
+    };
+
+    stack.push_back(trace.root);
+    while (!stack.empty()) {
+        const auto *span = stack.back();
+        stack.pop_back();
+
+        const auto [first, last] = childrenOf(span);
+        std::stable_sort(first, last, [&](const Span *a, const Span *b) {
+            return end[indexOf(a)] > end[indexOf(b)];
+        });
+        stack.insert(stack.end(), first, last);
+    }
+
+    auto addSection = [&path](const Span *span, TimePoint start, TimePoint finish, size_t i) {
+        if (start < finish) {
+            path.sections.push_back({span, start, finish});
+            path.contribution[i] += finish - start;
+        }
+    };
+
+    // every child is passed at most once since the cursor only moves back
+    struct Frame
+    {
+        const Span *span;
+        TimePoint cursor;
+        size_t next;
+    };
+
+    std::vector<Frame> frames;
+    frames.push_back({trace.root, end[rootIndex], 0});
+    while (!frames.empty()) {
+        auto &frame = frames.back();
+        const auto i = indexOf(frame.span);
+        const auto [first, last] = childrenOf(frame.span);
+        const auto count = static_cast<size_t>(last - first);
+
+        while (frame.next < count && end[indexOf(first[frame.next])] > frame.cursor) {
+            ++frame.next;
+        }
+
+        if (frame.next == count) {
+            addSection(frame.span, begin[i], frame.cursor, i);
+            frames.pop_back();
+            continue;
+        }
+
+        const auto *child = first[frame.next++];
+        const auto c = indexOf(child);
+        addSection(frame.span, end[c], frame.cursor, i);
+        frame.cursor = begin[c];
+        frames.push_back({child, end[c], 0});
+    }
+
+    std::reverse(path.sections.begin(), path.sections.end());
+    return path;
+}
+
+} // namespace graph
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "span.h"
+
+namespace graph {
+
+struct Trace;
+
+/*!
+ * Chain of spans that determined the end-to-end duration of a trace.
+ *
+ * Walking back from the end of the root, a span is blocked by the child that
+ * finished last before the current point; time not covered by such a child
+ * belongs to the span itself. Children are clamped to the bounds of their
+ * parent first, so spans reported outside of it do not extend the path.
+ */
+struct CriticalPath
+{
+    struct Section
+    {
+        const Span *span = nullptr;
+        TimePoint start;
+        TimePoint end;
+    };
+
+    //! ordered by time, sections of one span may be split by its children
+    std::vector<Section> sections;
+    //! time each span spends on the path, indexed like Trace::spans
+    std::vector<std::chrono::microseconds> contribution;
+
+    bool isEmpty() const noexcept { return sections.empty(); }
+
+    //! linear in the span count apart from ordering siblings by end time
+    static CriticalPath compute(const Trace &trace);
+};
+
+} // namespace graph
@@ -0,0 +1,173 @@
+#include <algorithm>
+
+#include "trace/parallel.h"
+
+#include "critical_path.h"
+#include "dependency_graph.h"
+#include "trace.h"
+
+namespace {
+
+//! independent of the order of the tags
+size_t tagsHash(const graph::Process &process)
+{
+    size_t hash = 0;
+    for (const auto &tag : process.tags) {
+        hash += qHashMulti(0, tag.key, tag.value.toString());
+    }
+    return hash;
+}
+
+//! tags of different sets may sum to the same hash
+bool sameTags(const graph::Process &a, const graph::Process &b)
+{
+    return std::is_permutation(a.tags.begin(),
+                               a.tags.end(),
+                               b.tags.begin(),
+                               b.tags.end(),
+                               [](const graph::Tag &x, const graph::Tag &y) {
+                                   return x.key == y.key && x.value == y.value;
+                               });
+}
+
+} // namespace
+
+namespace graph {
+
+quint32 DependencyGraph::serviceIndex(Process *process)
+{
+    const auto hash = grouping == Grouping::ByNameAndTags ? tagsHash(*process) : 0;
+    const auto key = std::make_pair(process->name, hash);
+
+    const auto [first, last] = m_serviceIndex.equal_range(key);
+    for (auto iter = first; iter != last; ++iter) {
+        if (grouping == Grouping::ByName || sameTags(*services[iter.value()].process, *process)) {
+            return iter.value();
+        }
+    }
+
+    const auto index = static_cast<quint32>(services.size());
+    services.push_back({process->name, hash, process});
+    m_serviceIndex.insert(key, index);
+    return index;
+}
+
+quint32 DependencyGraph::edgeIndex(quint32 from, quint32 to)
+{
+    const auto key = std::make_pair(from, to);
+
+    const auto iter = m_edgeIndex.constFind(key);
+    if (iter != m_edgeIndex.cend()) {
+        return iter.value();
+    }
+
+    const auto index = static_cast<quint32>(edges.size());
+    Edge edge;
+    edge.from = from;
+    edge.to = to;
+    edges.push_back(std::move(edge));
+    m_edgeIndex.insert(key, index);
+    return index;
+}
+
+void DependencyGraph::add(Trace &trace)
+{
+    // service of every process of the trace, processes are few and hashed once
+    std::vector<quint32> processServices;
+    processServices.reserve(trace.process.size());
+    for (auto &process : trace.process) {
+        processServices.push_back(serviceIndex(&process));
+    }
+
+    const auto serviceOf = [&](const Span &span) {
+        return processServices[static_cast<size_t>(span.process - trace.process.data())];
+    };
+
+    const auto criticalPath = CriticalPath::compute(trace);
+
+    for (auto &span : trace.spans) {
+        if (span.process == nullptr) {
+            continue;
+        }
+
+        const auto index = static_cast<size_t>(&span - trace.spans.data());
+        const auto criticalTime = criticalPath.isEmpty() ? std::chrono::microseconds(0)
+                                                         : criticalPath.contribution[index];
+
+        const auto to = serviceOf(span);
+        auto &service = services[to];
+        ++service.spanCount;
+        service.criticalTime += criticalTime;
+
+        if (span.parent == nullptr || span.parent->process == nullptr) {
+            continue;
+        }
+
+        const auto from = serviceOf(*span.parent);
+        if (from == to) {
+            continue;
+        }
+
+        auto &edge = edges[edgeIndex(from, to)];
+        edge.calls.push_back({&span, criticalTime});
+        edge.critical = edge.critical || criticalTime.count() > 0;
+    }
+}
+
+void DependencyGraph::merge(DependencyGraph &&other)
+{
+    std::vector<quint32> serviceMap;
+    serviceMap.reserve(other.services.size());
+    for (const auto &service : other.services) {
+        const auto known = services.size();
+        const auto index = serviceIndex(service.process);
+        if (index < known) {
+            services[index].spanCount += service.spanCount;
+            services[index].criticalTime += service.criticalTime;
+        } else {
+            services[index] = service;
+        }
+        serviceMap.push_back(index);
+    }
+
+    for (auto &edge : other.edges) {
+        auto &merged = edges[edgeIndex(serviceMap[edge.from], serviceMap[edge.to])];
+        if (merged.calls.empty()) {
+            merged.calls = std::move(edge.calls);
+        } else {
+            merged.calls.insert(merged.calls.end(), edge.calls.cbegin(), edge.calls.cend());
+        }
+        merged.critical = merged.critical || edge.critical;
+    }
+
+    other = DependencyGraph();
+}
+
+DependencyGraph DependencyGraph::build(const TraceGraph &graph, Grouping grouping, int threadCount)
+{
+    const auto traceCount = graph.traces.size();
+    const auto shardCount = static_cast<size_t>(std::max(threadCount, 1));
+
+    std::vector<DependencyGraph> shards(std::min(shardCount, std::max<size_t>(traceCount, 1)));
+    trace::parallelFor(static_cast<qsizetype>(shards.size()), threadCount, [&](qsizetype i) {
+        auto &shard = shards[static_cast<size_t>(i)];
+        shard.grouping = grouping;
+
+        const auto first = traceCount * static_cast<size_t>(i) / shards.size();
+        const auto last = traceCount * static_cast<size_t>(i + 1) / shards.size();
+        for (auto t = first; t < last; ++t) {
+            if (graph.traces[t]) {
+                shard.add(*graph.traces[t]);
+            }
+        }
+    });
+
+    auto result = std::move(shards.front());
+    for (size_t i = 1; i < shards.size(); ++i) {
+        result.merge(std::move(shards[i]));
+    }
+
+    return result;
+}
+
+} // namespace graph
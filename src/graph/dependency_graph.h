@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <QtCore/QHash>
+
+#include "process.h"
+#include "span.h"
+
+namespace graph {
+
+struct Trace;
+struct TraceGraph;
+
+/*!
+ * Services of many traces and the calls between them.
+ *
+ * Processes of every trace are merged into one node per service name, or per
+ * name and set of process tags, so a search result of hundreds of traces
+ * gives a graph as small as one of its traces. A span whose parent belongs to
+ * another service is a call along the edge between the two.
+ */
+struct DependencyGraph
+{
+    enum class Grouping : quint8 { ByName, ByNameAndTags };
+
+    struct Service
+    {
+        trace::Symbol name;
+        //! zero when grouped by name
+        size_t tagsHash = 0;
+        //! first process of the service, holds its tags
+        Process *process = nullptr;
+        quint64 spanCount = 0;
+        //! time spans of the service spend on the critical path of their traces
+        std::chrono::microseconds criticalTime{0};
+    };
+
+    struct Call
+    {
+        Span *span = nullptr;
+        std::chrono::microseconds criticalTime{0};
+    };
+
+    struct Edge
+    {
+        //! indexes in services
+        quint32 from = 0;
+        quint32 to = 0;
+        std::vector<Call> calls;
+        bool critical = false;
+    };
+
+    Grouping grouping = Grouping::ByName;
+    std::vector<Service> services;
+    std::vector<Edge> edges;
+
+    void add(Trace &trace);
+    //! services and edges of other that are not known yet are appended in their order
+    void merge(DependencyGraph &&other);
+
+    //! threadCount shards of consecutive traces are built in parallel and merged in order
+    static DependencyGraph build(const TraceGraph &graph,
+                                 Grouping grouping = Grouping::ByName,
+                                 int threadCount = 1);
+
+private:
+    quint32 serviceIndex(Process *process);
+    quint32 edgeIndex(quint32 from, quint32 to);
+
+private:
+    //! services of one name and tag hash, their tags are compared on a hit
+    QMultiHash<std::pair<trace::Symbol, size_t>, quint32> m_serviceIndex;
+    QHash<std::pair<quint32, quint32>, quint32> m_edgeIndex;
+};
+
+} // namespace graph
@@ -0,0 +1,101 @@
+#include <algorithm>
+
+#include "interval_index.h"
+#include "trace.h"
+
+namespace graph {
+
+IntervalIndex::IntervalIndex(const Trace &trace)
+{
+    m_entries.reserve(trace.spans.size());
+    m_ends.reserve(trace.spans.size());
+    for (const auto &span : trace.spans) {
+        const auto end = std::max(span.startTime + span.duration,
+                                  span.startTime + std::chrono::microseconds(1));
+        m_entries.push_back({span.startTime, end, &span});
+        m_ends.push_back(end);
+    }
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) {
+        return a.start < b.start;
+    });
+    std::sort(m_ends.begin(), m_ends.end());
+
+    m_maxEnd.resize(m_entries.size());
+    if (!m_entries.empty()) {
+        build(0, m_entries.size());
+    }
+}
+
+TimePoint IntervalIndex::build(size_t first, size_t last)
+{
+    // depth is log n, so is the depth of the recursion
+    const auto middle = first + (last - first) / 2;
+    auto maxEnd = m_entries[middle].end;
+    if (first < middle) {
+        maxEnd = std::max(maxEnd, build(first, middle));
+    }
+    if (middle + 1 < last) {
+        maxEnd = std::max(maxEnd, build(middle + 1, last));
+    }
+
+    m_maxEnd[middle] = maxEnd;
+    return maxEnd;
+}
+
+std::vector<const Span *> IntervalIndex::query(TimePoint from, TimePoint to) const
+{
+    std::vector<const Span *> spans;
+    if (from < to) {
+        collect(0, m_entries.size(), from, to, spans);
+    }
+    return spans;
+}
+
+void IntervalIndex::collect(size_t first,
+                            size_t last,
+                            TimePoint from,
+                            TimePoint to,
+                            std::vector<const Span *> &spans) const
+{
+    if (first >= last) {
+        return;
+    }
+
+    const auto middle = first + (last - first) / 2;
+    if (m_maxEnd[middle] <= from) {
+        return;
+    }
+
+    collect(first, middle, from, to, spans);
+
+    const auto &entry = m_entries[middle];
+    if (entry.start >= to) {
+        return;
+    }
+    if (entry.end > from) {
+        spans.push_back(entry.span);
+    }
+
+    collect(middle + 1, last, from, to, spans);
+}
+
+size_t IntervalIndex::count(TimePoint from, TimePoint to) const
+{
+    if (!(from < to)) {
+        return 0;
+    }
+
+    // every span but those starting at or after to and those ending at or before from
+    const auto startsAfter = static_cast<size_t>(
+        m_entries.end()
+        - std::lower_bound(m_entries.begin(), m_entries.end(), to, [](const Entry &e, TimePoint t) {
+              return e.start < t;
+          }));
+    const auto endsBefore = static_cast<size_t>(
+        std::upper_bound(m_ends.begin(), m_ends.end(), from) - m_ends.begin());
+
+    return m_entries.size() - startsAfter - endsBefore;
+}
+
+} // namespace graph
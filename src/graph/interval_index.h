@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "span.h"
+
+namespace graph {
+
+struct Trace;
+
+/*!
+ * Spans of a trace by their time range, for zoom and brushing.
+ *
+ * Spans are sorted by start time and laid out as an implicit balanced tree:
+ * the middle of every range is its root and keeps the latest end of the
+ * range. A window query skips every subtree that ends before the window or
+ * starts after it. Counts come from two sorted endpoint arrays. A span is
+ * active in [from, to) when it starts before to and ends after from, an
+ * instant span counts as lasting one microsecond.
+ */
+class IntervalIndex
+{
+public:
+    IntervalIndex() = default;
+    explicit IntervalIndex(const Trace &trace);
+
+    size_t size() const noexcept { return m_entries.size(); }
+
+    //! spans active in [from, to) ordered by start time, O(log n + k) for k spans
+    std::vector<const Span *> query(TimePoint from, TimePoint to) const;
+    //! number of spans active in [from, to), O(log n)
+    size_t count(TimePoint from, TimePoint to) const;
+
+private:
+    struct Entry
+    {
+        TimePoint start;
+        TimePoint end;
+        const Span *span;
+    };
+
+    //! latest end of [first, last), stored at its middle
+    TimePoint build(size_t first, size_t last);
+    void collect(size_t first,
+                 size_t last,
+                 TimePoint from,
+                 TimePoint to,
+                 std::vector<const Span *> &spans) const;
+
+private:
+    //! by start time
+    std::vector<Entry> m_entries;
+    //! latest end of the range whose middle is the index
+    std::vector<TimePoint> m_maxEnd;
+    std::vector<TimePoint> m_ends;
+};
+
+} // namespace graph
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+
+#include <QtCore/QtAlgorithms>
+
+#include "latency.h"
+#include "trace.h"
+
+namespace {
+constexpr quint64 SubBuckets = quint64(1) << graph::LatencyHistogram::PrecisionBits;
+constexpr quint64 HalfSubBuckets = SubBuckets / 2;
+} // namespace
+
+namespace graph {
+
+size_t LatencyHistogram::bucketIndex(quint64 value) noexcept
+{
+    if (value < SubBuckets) {
+        return static_cast<size_t>(value);
+    }
+
+    // value >> shift keeps PrecisionBits significant bits, the top one is always set
+    const auto bits = 64 - static_cast<quint64>(qCountLeadingZeroBits(value));
+    const auto shift = bits - PrecisionBits;
+    return static_cast<size_t>(shift * HalfSubBuckets + (value >> shift));
+}
+
+quint64 LatencyHistogram::bucketHighest(size_t index) noexcept
+{
+    if (index < SubBuckets) {
+        return index;
+    }
+
+    const auto shift = index / HalfSubBuckets - 1;
+    const auto mantissa = index - shift * HalfSubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::reserveBucket(size_t index)
+{
+    if (m_counts.empty()) {
+        m_offset = index;
+        m_counts.resize(1);
+    } else if (index < m_offset) {
+        m_counts.insert(m_counts.begin(), m_offset - index, 0);
+        m_offset = index;
+    } else if (index >= m_offset + m_counts.size()) {
+        m_counts.resize(index - m_offset + 1);
+    }
+}
+
+void LatencyHistogram::record(std::chrono::microseconds value, quint64 count)
+{
+    const auto v = static_cast<quint64>(std::max<qint64>(value.count(), 0));
+    const auto index = bucketIndex(v);
+    reserveBucket(index);
+    m_counts[index - m_offset] += count;
+
+    m_min = m_count == 0 ? v : std::min(m_min, v);
+    m_max = m_count == 0 ? v : std::max(m_max, v);
+    m_count += count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+
+    reserveBucket(other.m_offset);
+    reserveBucket(other.m_offset + other.m_counts.size() - 1);
+    for (size_t i = 0; i < other.m_counts.size(); ++i) {
+        m_counts[other.m_offset + i - m_offset] += other.m_counts[i];
+    }
+
+    m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+    m_max = m_count == 0 ? other.m_max : std::max(m_max, other.m_max);
+    m_count += other.m_count;
+}
+
+std::chrono::microseconds LatencyHistogram::percentile(double q) const
+{
+    if (m_count == 0) {
+        return std::chrono::microseconds::zero();
+    }
+
+    const auto rank = std::max<quint64>(
+        1, static_cast<quint64>(std::ceil(std::clamp(q, 0.0, 1.0) * double(m_count))));
+
+    quint64 seen = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        seen += m_counts[i];
+        if (seen >= rank) {
+            const auto value = std::clamp(bucketHighest(m_offset + i), m_min, m_max);
+            return std::chrono::microseconds(static_cast<qint64>(value));
+        }
+    }
+
+    return max();
+}
+
+void LatencyStats::add(const Trace &trace)
+{
+    for (const auto &span : trace.spans) {
+        const LatencyKey key{span.process != nullptr ? span.process->name : trace::Symbol(),
+                             span.operationName};
+        m_histograms[key].record(span.duration);
+    }
+}
+
+void LatencyStats::merge(const LatencyStats &other)
+{
+    for (auto iter = other.m_histograms.cbegin(); iter != other.m_histograms.cend(); ++iter) {
+        m_histograms[iter.key()].merge(iter.value());
+    }
+}
+
+} // namespace graph
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <QtCore/QHash>
+
+#include "trace/symbol.h"
+
+namespace graph {
+
+struct Trace;
+
+/*!
+ * Log-linear histogram of durations in the spirit of HdrHistogram.
+ *
+ * Values below 2^PrecisionBits microseconds get a bucket each, larger ones
+ * share a bucket with values that differ by less than 1/64 of them. Only
+ * the buckets between the smallest and the largest value are allocated, and
+ * histograms of different traces merge by adding counts.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int PrecisionBits = 7;
+
+    void record(std::chrono::microseconds value, quint64 count = 1);
+    void merge(const LatencyHistogram &other);
+
+    quint64 count() const noexcept { return m_count; }
+    std::chrono::microseconds min() const noexcept { return std::chrono::microseconds(m_min); }
+    std::chrono::microseconds max() const noexcept { return std::chrono::microseconds(m_max); }
+
+    //! largest value of the bucket that holds quantile q, q in [0, 1]
+    std::chrono::microseconds percentile(double q) const;
+
+    static size_t bucketIndex(quint64 value) noexcept;
+    //! largest value that falls into the bucket
+    static quint64 bucketHighest(size_t index) noexcept;
+
+private:
+    //! grow the counts to cover index, buckets keep their values
+    void reserveBucket(size_t index);
+
+private:
+    size_t m_offset = 0;
+    std::vector<quint64> m_counts;
+    quint64 m_count = 0;
+    quint64 m_min = 0;
+    quint64 m_max = 0;
+};
+
+struct LatencyKey
+{
+    trace::Symbol service;
+    trace::Symbol operation;
+
+    friend bool operator==(const LatencyKey &a, const LatencyKey &b) noexcept
+    {
+        return a.service == b.service && a.operation == b.operation;
+    }
+};
+
+inline size_t qHash(const LatencyKey &key, size_t seed = 0) noexcept
+{
+    return qHashMulti(seed, key.service, key.operation);
+}
+
+//! span durations per service and operation
+class LatencyStats
+{
+public:
+    void add(const Trace &trace);
+    void merge(const LatencyStats &other);
+
+    bool isEmpty() const noexcept { return m_histograms.isEmpty(); }
+    const QHash<LatencyKey, LatencyHistogram> &histograms() const noexcept { return m_histograms; }
+
+private:
+    QHash<LatencyKey, LatencyHistogram> m_histograms;
+};
+
+} // namespace graph
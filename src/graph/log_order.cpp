@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <queue>
+#include <tuple>
+
+#include "trace/parallel.h"
+
+#include "log_order.h"
+#include "trace.h"
+
+namespace {
+
+struct Key
+{
+    qint64 timestamp;
+    quint32 span;
+    quint32 log;
+
+    friend bool operator<(const Key &a, const Key &b) noexcept
+    {
+        return std::tie(a.timestamp, a.span, a.log) < std::tie(b.timestamp, b.span, b.log);
+    }
+};
+
+static_assert(sizeof(Key) == 16, "keys stay compact");
+
+//! merge sorted runs [offsets[i], offsets[i + 1]) of input for i in [first, last) into output
+void mergeRuns(const std::vector<Key> &input,
+               const std::vector<size_t> &offsets,
+               size_t first,
+               size_t last,
+               Key *output)
+{
+    if (last - first == 1) {
+        std::copy(input.begin() + offsets[first], input.begin() + offsets[last], output);
+        return;
+    }
+
+    struct Head
+    {
+        size_t position;
+        size_t end;
+    };
+    const auto later = [&input](const Head &a, const Head &b) {
+        return input[b.position] < input[a.position];
+    };
+
+    std::vector<Head> heads;
+    heads.reserve(last - first);
+    for (auto run = first; run < last; ++run) {
+        if (offsets[run] < offsets[run + 1]) {
+            heads.push_back({offsets[run], offsets[run + 1]});
+        }
+    }
+
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> queue(later, std::move(heads));
+    while (!queue.empty()) {
+        auto head = queue.top();
+        queue.pop();
+        *output++ = input[head.position++];
+        if (head.position < head.end) {
+            queue.push(head);
+        }
+    }
+}
+
+} // namespace
+
+namespace graph {
+
+std::vector<LogRef> orderLogs(const TraceGraph &graph, int threadCount)
+{
+    // every span with logs is a run, offsets[i] is where its keys start
+    std::vector<Span *> spans;
+    std::vector<size_t> offsets{0};
+    for (const auto &tr : graph.traces) {
+        if (!tr) {
+            continue;
+        }
+        for (auto &span : tr->spans) {
+            if (!span.logs.empty()) {
+                spans.push_back(&span);
+                offsets.push_back(offsets.back() + span.logs.size());
+            }
+        }
+    }
+
+    const auto runCount = spans.size();
+    std::vector<Key> keys(offsets.back());
+    trace::parallelFor(static_cast<qsizetype>(runCount), threadCount, [&](qsizetype i) {
+        const auto run = static_cast<size_t>(i);
+        const auto &logs = spans[run]->logs;
+        auto *first = keys.data() + offsets[run];
+        for (size_t k = 0; k < logs.size(); ++k) {
+            first[k] = {logs[k].timestamp.time_since_epoch().count(),
+                        static_cast<quint32>(run),
+                        static_cast<quint32>(k)};
+        }
+        if (!std::is_sorted(first, first + logs.size())) {
+            std::sort(first, first + logs.size());
+        }
+    });
+
+    // consecutive runs per group, each group becomes one sorted run of merged
+    const auto groupCount = std::clamp<size_t>(static_cast<size_t>(threadCount), 1,
+                                               std::max<size_t>(runCount, 1));
+    std::vector<size_t> groups(groupCount + 1);
+    for (size_t g = 0; g <= groupCount; ++g) {
+        groups[g] = runCount * g / groupCount;
+    }
+
+    std::vector<Key> merged(keys.size());
+    if (groupCount > 1) {
+        trace::parallelFor(static_cast<qsizetype>(groupCount), threadCount, [&](qsizetype i) {
+            const auto g = static_cast<size_t>(i);
+            mergeRuns(keys, offsets, groups[g], groups[g + 1], merged.data() + offsets[groups[g]]);
+        });
+
+        std::vector<size_t> groupOffsets(groupCount + 1);
+        for (size_t g = 0; g <= groupCount; ++g) {
+            groupOffsets[g] = offsets[groups[g]];
+        }
+        mergeRuns(merged, groupOffsets, 0, groupCount, keys.data());
+        std::swap(keys, merged);
+    } else if (runCount != 0) {
+        mergeRuns(keys, offsets, 0, runCount, merged.data());
+    }
+
+    std::vector<LogRef> order(merged.size());
+    trace::parallelFor(static_cast<qsizetype>(groupCount), threadCount, [&](qsizetype i) {
+        const auto first = merged.size() * static_cast<size_t>(i) / groupCount;
+        const auto last = merged.size() * static_cast<size_t>(i + 1) / groupCount;
+        for (auto k = first; k < last; ++k) {
+            order[k] = {spans[merged[k].span], merged[k].log};
+        }
+    });
+
+    return order;
+}
+
+} // namespace graph
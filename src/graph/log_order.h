@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "span.h"
+
+namespace graph {
+
+struct TraceGraph;
+
+//! log record of a span by position, see Span::logs
+struct LogRef
+{
+    Span *span = nullptr;
+    quint32 log = 0;
+
+    const LogRecord &record() const { return span->logs[log]; }
+};
+
+/*!
+ * Decoded logs of every trace of the graph ordered by timestamp, ties by
+ * span and position.
+ *
+ * Logs of a span are usually already in order, so each span is a sorted run
+ * of compact (timestamp, span, log) keys, and the few runs that are not get
+ * sorted on their own. threadCount groups of runs are merged in parallel by a
+ * k-way merge, and the groups are merged in a last pass. This is O(n log k)
+ * for n logs in k spans, and no comparison dereferences a span.
+ */
+std::vector<LogRef> orderLogs(const TraceGraph &graph, int threadCount = 1);
+
+} // namespace graph
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <iterator>
+
+#include "trace/parallel.h"
+
+#include "log_search.h"
+
+namespace {
+
+void toLowerAscii(QByteArray *text)
+{
+    for (auto &c : *text) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+}
+
+quint32 trigram(const char *bytes)
+{
+    return (quint32(quint8(bytes[0])) << 16) | (quint32(quint8(bytes[1])) << 8)
+           | quint32(quint8(bytes[2]));
+}
+
+using Postings = QHash<quint32, std::vector<quint32>>;
+
+void addRow(Postings &postings, const QByteArray &text, quint32 row)
+{
+    for (qsizetype i = 0; i + 3 <= text.size(); ++i) {
+        auto &rows = postings[trigram(text.constData() + i)];
+        // a trigram repeated in one log is listed once
+        if (rows.empty() || rows.back() != row) {
+            rows.push_back(row);
+        }
+    }
+}
+
+} // namespace
+
+namespace graph {
+
+void LogSearchIndex::logText(const LogRecord &record,
+                             const trace::Source &keeper,
+                             QByteArray *text)
+{
+    text->clear();
+    for (const auto &field : record.decodeFields(keeper)) {
+        text->append(field.key.utf8());
+        text->append('=');
+        if (field.value.isString()) {
+            text->append(field.value.utf8());
+        } else {
+            text->append(field.value.toString().toUtf8());
+        }
+        text->append(' ');
+    }
+    toLowerAscii(text);
+}
+
+LogSearchIndex LogSearchIndex::build(const std::vector<LogRef> &logs, int threadCount)
+{
+    const auto shardCount = std::clamp<size_t>(static_cast<size_t>(threadCount),
+                                               1,
+                                               std::max<size_t>(logs.size(), 1));
+
+    std::vector<Postings> shards(shardCount);
+    trace::parallelFor(static_cast<qsizetype>(shardCount), threadCount, [&](qsizetype i) {
+        const auto shard = static_cast<size_t>(i);
+        const auto first = logs.size() * shard / shardCount;
+        const auto last = logs.size() * (shard + 1) / shardCount;
+
+        const auto keeper = trace::Source::fromData(QByteArray());
+        QByteArray text;
+        for (auto row = first; row < last; ++row) {
+            logText(logs[row].record(), *keeper, &text);
+            addRow(shards[shard], text, static_cast<quint32>(row));
+        }
+    });
+
+    // shards hold consecutive rows, appending them in order keeps every list sorted
+    LogSearchIndex index;
+    index.m_postings = std::move(shards.front());
+    for (size_t shard = 1; shard < shards.size(); ++shard) {
+        for (auto iter = shards[shard].begin(); iter != shards[shard].end(); ++iter) {
+            auto &rows = index.m_postings[iter.key()];
+            if (rows.empty()) {
+                rows = std::move(iter.value());
+            } else {
+                rows.insert(rows.end(), iter.value().cbegin(), iter.value().cend());
+            }
+        }
+        shards[shard].clear();
+    }
+
+    return index;
+}
+
+std::vector<quint32> LogSearchIndex::search(const std::vector<LogRef> &logs,
+                                            QByteArrayView query) const
+{
+    auto needle = query.toByteArray();
+    toLowerAscii(&needle);
+
+    std::vector<quint32> rows;
+    const auto keeper = trace::Source::fromData(QByteArray());
+    QByteArray text;
+    const auto matches = [&](quint32 row) {
+        logText(logs[row].record(), *keeper, &text);
+        return text.contains(needle);
+    };
+
+    if (needle.size() < 3 || m_postings.isEmpty()) {
+        for (quint32 row = 0; row < logs.size(); ++row) {
+            if (matches(row)) {
+                rows.push_back(row);
+            }
+        }
+        return rows;
+    }
+
+    std::vector<const std::vector<quint32> *> lists;
+    for (qsizetype i = 0; i + 3 <= needle.size(); ++i) {
+        const auto iter = m_postings.constFind(trigram(needle.constData() + i));
+        if (iter == m_postings.cend()) {
+            return rows;
+        }
+        lists.push_back(&iter.value());
+    }
+    // shortest first, a trigram repeated in the query is intersected once
+    std::sort(lists.begin(), lists.end(), [](const auto *a, const auto *b) {
+        return std::make_pair(a->size(), a) < std::make_pair(b->size(), b);
+    });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+    rows = *lists.front();
+    std::vector<quint32> next;
+    for (size_t i = 1; i < lists.size() && !rows.empty(); ++i) {
+        next.clear();
+        std::set_intersection(rows.cbegin(),
+                              rows.cend(),
+                              lists[i]->cbegin(),
+                              lists[i]->cend(),
+                              std::back_inserter(next));
+        rows.swap(next);
+    }
+
+    // every trigram is present, the query may still not be contiguous
+    if (needle.size() > 3) {
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [&](quint32 row) {
+                       return !matches(row);
+                   }),
+                   rows.end());
+    }
+
+    return rows;
+}
+
+} // namespace graph
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+
+#include "trace/source.h"
+
+#include "log_order.h"
+
+namespace graph {
+
+/*!
+ * Trigram index over the fields of logs, to search them while typing.
+ *
+ * The text of a log is "key=value " for each of its fields with ASCII letters
+ * lowercased. Every trigram of the text maps to the increasing rows that hold
+ * it. A query intersects the lists of its trigrams, shortest first, and checks
+ * the rows left against their text unless the query is a single trigram.
+ * Queries shorter than a trigram, and queries before the index is built, scan.
+ */
+class LogSearchIndex
+{
+public:
+    //! rows are positions in logs, threadCount shards of consecutive rows are built in parallel
+    static LogSearchIndex build(const std::vector<LogRef> &logs, int threadCount = 1);
+
+    bool isEmpty() const noexcept { return m_postings.isEmpty(); }
+
+    //! increasing rows of logs that contain the query, logs are the ones the index is built from
+    std::vector<quint32> search(const std::vector<LogRef> &logs, QByteArrayView query) const;
+
+    //! lowercased text of the record, replaces the content of text, see LogRecord::decodeFields
+    static void logText(const LogRecord &record, const trace::Source &keeper, QByteArray *text);
+
+private:
+    QHash<quint32, std::vector<quint32>> m_postings;
+};
+
+} // namespace graph
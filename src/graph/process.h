@@ -2,13 +2,14 @@
 
 #include <QtCore/QString>
 
+#include "range.h"
 #include "tag.h"
 
 namespace graph {
 
 struct Process
 {
-    QString name;
-    Tags tags;
+    trace::Symbol name;
+    Range<const Tag> tags;
 };
 } // namespace graph
\ No newline at end of file
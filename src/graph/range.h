@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+namespace graph {
+
+//! consecutive elements inside one of the pools of a Trace
+template<typename T>
+class Range
+{
+public:
+    constexpr Range() = default;
+    constexpr Range(T *first, size_t size) noexcept
+        : m_first(first)
+        , m_size(size)
+    {}
+
+    constexpr T *begin() const noexcept { return m_first; }
+    constexpr T *end() const noexcept { return m_first + m_size; }
+    constexpr size_t size() const noexcept { return m_size; }
+    constexpr bool empty() const noexcept { return m_size == 0; }
+    constexpr T &operator[](size_t i) const noexcept { return m_first[i]; }
+
+private:
+    T *m_first = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace graph
@@ -0,0 +1,987 @@
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QSaveFile>
+
+#include "trace/parallel.h"
+#include "trace/string_ref.h"
+#include "trace/value.h"
+
+#include "snapshot.h"
+
+namespace {
+
+constexpr char Magic[8] = {'J', 'G', 'V', 'S', 'N', 'A', 'P', '\0'};
+constexpr quint32 ByteOrderMark = 0x01020304;
+constexpr quint32 NoIndex = std::numeric_limits<quint32>::max();
+
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 payloadSize;
+    quint64 checksum; //!< of the payload, everything after the header
+    quint32 sectionCount;
+    quint32 reserved;
+};
+
+//! payload starts with sectionCount entries, sections follow 8-byte aligned
+struct SectionEntry
+{
+    quint32 id;
+    quint32 reserved;
+    quint64 offset; //!< from the start of the payload
+    quint64 size;
+};
+
+enum class SectionId : quint32 {
+    StringOffsets,    // quint64, strings + 1
+    StringData,       // UTF-8 bytes of all strings
+    Traces,           // TraceRecord
+    Processes,        // ProcessRecord
+    SpanIDs,          // quint64
+    SpanTraceIDs,     // TraceIDRecord
+    SpanOperations,   // quint32 string
+    SpanProcesses,    // quint32 process of the trace or NoIndex
+    SpanParents,      // quint32 span of the trace or NoIndex
+    SpanStartTimes,   // qint64 microseconds since epoch
+    SpanDurations,    // qint64 microseconds
+    SpanShifts,       // qint64 microseconds
+    SpanChildOffsets, // quint32, spans + 1
+    SpanTagOffsets,   // quint32, spans + 1
+    SpanLogOffsets,   // quint32, spans + 1
+    Children,         // quint32 span of the trace
+    LogTimestamps,    // qint64 microseconds since epoch
+    LogLevels,        // quint8 graph::LogRecord::Level
+    LogErrors,        // quint8
+    LogFieldOffsets,  // quint32, logs + 1
+    ValueKeys,        // quint32 string
+    ValueTypes,       // quint8 ValueType
+    ValueData,        // qint64 string index, integer, bool or double bits
+    Count,
+};
+
+struct TraceIDRecord
+{
+    quint64 high;
+    quint64 low;
+    quint32 wide; //!< 1 when written with 32 digits
+    quint32 reserved;
+};
+
+struct TraceRecord
+{
+    TraceIDRecord traceID;
+    quint32 root; //!< span of the trace or NoIndex
+    quint32 firstSpan;
+    quint32 spanCount;
+    quint32 firstProcess;
+    quint32 processCount;
+    quint32 reserved;
+};
+
+struct ProcessRecord
+{
+    quint32 name;
+    quint32 firstTag;
+    quint32 tagCount;
+    quint32 reserved;
+};
+
+//! stored type codes, independent of trace::Value::Type
+enum class ValueType : quint8 { Null, String, Int64, Bool, Double, Binary };
+
+quint64 align8(quint64 size)
+{
+    return (size + 7) & ~quint64(7);
+}
+
+quint64 rotl(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+//! fast non-cryptographic hash, detects truncated and corrupted files
+quint64 checksum(QByteArrayView data)
+{
+    constexpr quint64 Prime1 = 0x9E3779B185EBCA87ULL;
+    constexpr quint64 Prime2 = 0xC2B2AE3D27D4EB4FULL;
+
+    const auto *p = data.data();
+    const auto size = static_cast<quint64>(data.size());
+
+    // four independent lanes keep several multiplications in flight
+    quint64 lanes[4] = {Prime1 + Prime2, Prime2, 0, ~Prime1};
+    quint64 i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            quint64 word = 0;
+            std::memcpy(&word, p + i + lane * 8, sizeof(word));
+            lanes[lane] = rotl(lanes[lane] + word * Prime2, 31) * Prime1;
+        }
+    }
+
+    quint64 hash = size;
+    for (auto lane : lanes) {
+        hash = rotl(hash ^ (rotl(lane * Prime2, 31) * Prime1), 27) * Prime1 + Prime2;
+    }
+
+    for (; i < size; ++i) {
+        hash = rotl(hash ^ (static_cast<quint8>(p[i]) * Prime1), 11) * Prime2;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+void setError(graph::SnapshotError *error, graph::SnapshotError::Error err)
+{
+    if (error != nullptr) {
+        error->error = err;
+    }
+}
+
+class Writer
+{
+public:
+    Writer()
+    {
+        // string 0 is the empty string
+        string(QByteArrayView());
+    }
+
+    bool add(const graph::TraceGraph &graph);
+    QByteArray payload() const;
+
+private:
+    quint32 string(QByteArrayView utf8);
+    quint32 symbol(trace::Symbol symbol);
+
+    template<typename KeyValues>
+    void addValues(const KeyValues &values);
+
+    template<typename T>
+    static std::vector<T> offsets()
+    {
+        return std::vector<T>(1, 0);
+    }
+
+private:
+    std::vector<quint64> m_stringOffsets = offsets<quint64>();
+    QByteArray m_stringData;
+    QHash<QByteArray, quint32> m_strings;
+    QHash<trace::Symbol, quint32> m_symbols;
+
+    std::vector<TraceRecord> m_traces;
+    std::vector<ProcessRecord> m_processes;
+
+    std::vector<quint64> m_spanIDs;
+    std::vector<TraceIDRecord> m_spanTraceIDs;
+    std::vector<quint32> m_spanOperations;
+    std::vector<quint32> m_spanProcesses;
+    std::vector<quint32> m_spanParents;
+    std::vector<qint64> m_spanStartTimes;
+    std::vector<qint64> m_spanDurations;
+    std::vector<qint64> m_spanShifts;
+    std::vector<quint32> m_spanChildOffsets = offsets<quint32>();
+    std::vector<quint32> m_spanTagOffsets = offsets<quint32>();
+    std::vector<quint32> m_spanLogOffsets = offsets<quint32>();
+    std::vector<quint32> m_children;
+
+    std::vector<qint64> m_logTimestamps;
+    std::vector<quint8> m_logLevels;
+    std::vector<quint8> m_logErrors;
+    std::vector<quint32> m_logFieldOffsets = offsets<quint32>();
+
+    std::vector<quint32> m_valueKeys;
+    std::vector<quint8> m_valueTypes;
+    std::vector<qint64> m_valueData;
+};
+
+quint32 Writer::string(QByteArrayView utf8)
+{
+    const auto lookup = QByteArray::fromRawData(utf8.data(), utf8.size());
+    const auto iter = m_strings.constFind(lookup);
+    if (iter != m_strings.constEnd()) {
+        return *iter;
+    }
+
+    const auto id = static_cast<quint32>(m_stringOffsets.size() - 1);
+    m_strings.insert(utf8.toByteArray(), id);
+    m_stringData.append(utf8);
+    m_stringOffsets.push_back(static_cast<quint64>(m_stringData.size()));
+
+    return id;
+}
+
+quint32 Writer::symbol(trace::Symbol symbol)
+{
+    const auto iter = m_symbols.constFind(symbol);
+    if (iter != m_symbols.constEnd()) {
+        return *iter;
+    }
+
+    const auto id = string(symbol.toString().toUtf8());
+    m_symbols.insert(symbol, id);
+    return id;
+}
+
+template<typename KeyValues>
+void Writer::addValues(const KeyValues &values)
+{
+    for (const auto &value : values) {
+        m_valueKeys.push_back(symbol(value.key));
+
+        const auto &v = value.value;
+
+        qint64 data = 0;
+        ValueType type = ValueType::Null;
+        switch (v.type()) {
+        case trace::Value::Type::Null:
+            break;
+        case trace::Value::Type::String:
+            type = ValueType::String;
+            data = string(v.utf8());
+            break;
+        case trace::Value::Type::Binary:
+            type = ValueType::Binary;
+            data = string(v.utf8());
+            break;
+        case trace::Value::Type::Bool:
+            type = ValueType::Bool;
+            data = v.toBool() ? 1 : 0;
+            break;
+        case trace::Value::Type::Int64:
+            type = ValueType::Int64;
+            data = v.toInt64();
+            break;
+        case trace::Value::Type::Float64: {
+            type = ValueType::Double;
+            const double number = v.toDouble();
+            std::memcpy(&data, &number, sizeof(data));
+            break;
+        }
+        }
+
+        m_valueTypes.push_back(static_cast<quint8>(type));
+        m_valueData.push_back(data);
+    }
+}
+
+bool Writer::add(const graph::TraceGraph &graph)
+{
+    for (const auto &tracePtr : graph.traces) {
+        if (!tracePtr) {
+            continue;
+        }
+
+        const auto &tr = *tracePtr;
+        // escaped strings of log fields are copied into the string table before it goes away
+        const auto keeper = trace::Source::fromData(QByteArray());
+
+        TraceRecord record{};
+        record.traceID = {tr.traceID.high(), tr.traceID.low(), tr.traceID.isWide(), 0};
+        record.firstSpan = static_cast<quint32>(m_spanIDs.size());
+        record.spanCount = static_cast<quint32>(tr.spans.size());
+        record.firstProcess = static_cast<quint32>(m_processes.size());
+        record.processCount = static_cast<quint32>(tr.process.size());
+
+        // spans and processes are contiguous, indexes are pointer offsets
+        auto processIndex = [&tr](const graph::Process *process) {
+            return process != nullptr ? static_cast<quint32>(process - tr.process.data())
+                                      : NoIndex;
+        };
+        auto spanIndex = [&tr](const graph::Span *span) {
+            return span != nullptr ? static_cast<quint32>(span - tr.spans.data()) : NoIndex;
+        };
+
+        for (const auto &process : tr.process) {
+            ProcessRecord rec{};
+            rec.name = symbol(process.name);
+            rec.firstTag = static_cast<quint32>(m_valueKeys.size());
+            rec.tagCount = static_cast<quint32>(process.tags.size());
+            addValues(process.tags);
+            m_processes.push_back(rec);
+        }
+
+        record.root = spanIndex(tr.root);
+
+        for (const auto &span : tr.spans) {
+            m_spanIDs.push_back(span.spanID.value());
+            m_spanTraceIDs.push_back(
+                {span.traceID.high(), span.traceID.low(), span.traceID.isWide(), 0});
+            m_spanOperations.push_back(symbol(span.operationName));
+            m_spanProcesses.push_back(processIndex(span.process));
+            m_spanParents.push_back(spanIndex(span.parent));
+            m_spanStartTimes.push_back(span.startTime.time_since_epoch().count());
+            m_spanDurations.push_back(span.duration.count());
+            m_spanShifts.push_back(span.shift.count());
+
+            for (const auto *child : span.children) {
+                m_children.push_back(spanIndex(child));
+            }
+            m_spanChildOffsets.push_back(static_cast<quint32>(m_children.size()));
+
+            addValues(span.tags);
+            m_spanTagOffsets.push_back(static_cast<quint32>(m_valueKeys.size()));
+
+            for (const auto &log : span.logs) {
+                m_logTimestamps.push_back(log.timestamp.time_since_epoch().count());
+                m_logLevels.push_back(static_cast<quint8>(log.level));
+                m_logErrors.push_back(log.hasError ? 1 : 0);
+                addValues(log.decodeFields(*keeper));
+                m_logFieldOffsets.push_back(static_cast<quint32>(m_valueKeys.size()));
+            }
+            m_spanLogOffsets.push_back(static_cast<quint32>(m_logTimestamps.size()));
+        }
+
+        m_traces.push_back(record);
+    }
+
+    // every index and offset is 32 bit
+    const size_t sizes[] = {
+        m_stringOffsets.size(),
+        m_spanIDs.size(),
+        m_children.size(),
+        m_logTimestamps.size(),
+        m_valueKeys.size(),
+    };
+    for (auto size : sizes) {
+        if (size >= NoIndex) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QByteArray Writer::payload() const
+{
+    struct Blob
+    {
+        SectionId id;
+        const void *data;
+        quint64 size;
+    };
+
+    auto blob = [](SectionId id, const auto &column) {
+        using T = typename std::decay_t<decltype(column)>::value_type;
+        return Blob{id, column.data(), column.size() * sizeof(T)};
+    };
+
+    const Blob blobs[] = {
+        blob(SectionId::StringOffsets, m_stringOffsets),
+        Blob{SectionId::StringData,
+             m_stringData.constData(),
+             static_cast<quint64>(m_stringData.size())},
+        blob(SectionId::Traces, m_traces),
+        blob(SectionId::Processes, m_processes),
+        blob(SectionId::SpanIDs, m_spanIDs),
+        blob(SectionId::SpanTraceIDs, m_spanTraceIDs),
+        blob(SectionId::SpanOperations, m_spanOperations),
+        blob(SectionId::SpanProcesses, m_spanProcesses),
+        blob(SectionId::SpanParents, m_spanParents),
+        blob(SectionId::SpanStartTimes, m_spanStartTimes),
+        blob(SectionId::SpanDurations, m_spanDurations),
+        blob(SectionId::SpanShifts, m_spanShifts),
+        blob(SectionId::SpanChildOffsets, m_spanChildOffsets),
+        blob(SectionId::SpanTagOffsets, m_spanTagOffsets),
+        blob(SectionId::SpanLogOffsets, m_spanLogOffsets),
+        blob(SectionId::Children, m_children),
+        blob(SectionId::LogTimestamps, m_logTimestamps),
+        blob(SectionId::LogLevels, m_logLevels),
+        blob(SectionId::LogErrors, m_logErrors),
+        blob(SectionId::LogFieldOffsets, m_logFieldOffsets),
+        blob(SectionId::ValueKeys, m_valueKeys),
+        blob(SectionId::ValueTypes, m_valueTypes),
+        blob(SectionId::ValueData, m_valueData),
+    };
+    static_assert(sizeof(blobs) / sizeof(Blob) == static_cast<size_t>(SectionId::Count));
+
+    quint64 total = align8(sizeof(SectionEntry) * std::size(blobs));
+    for (const auto &b : blobs) {
+        total += align8(b.size);
+    }
+
+    QByteArray payload(static_cast<qsizetype>(total), '\0');
+    auto *entries = reinterpret_cast<SectionEntry *>(payload.data());
+
+    quint64 offset = align8(sizeof(SectionEntry) * std::size(blobs));
+    for (size_t i = 0; i < std::size(blobs); ++i) {
+        const auto &b = blobs[i];
+        entries[i] = SectionEntry{static_cast<quint32>(b.id), 0, offset, b.size};
+        if (b.size != 0) {
+            std::memcpy(payload.data() + offset, b.data, b.size);
+        }
+        offset += align8(b.size);
+    }
+
+    return payload;
+}
+
+template<typename T>
+struct Column
+{
+    const T *data = nullptr;
+    quint64 size = 0;
+
+    const T &operator[](quint64 i) const noexcept { return data[i]; }
+};
+
+struct Columns
+{
+    Column<quint64> stringOffsets;
+    Column<char> stringData;
+    Column<TraceRecord> traces;
+    Column<ProcessRecord> processes;
+    Column<quint64> spanIDs;
+    Column<TraceIDRecord> spanTraceIDs;
+    Column<quint32> spanOperations;
+    Column<quint32> spanProcesses;
+    Column<quint32> spanParents;
+    Column<qint64> spanStartTimes;
+    Column<qint64> spanDurations;
+    Column<qint64> spanShifts;
+    Column<quint32> spanChildOffsets;
+    Column<quint32> spanTagOffsets;
+    Column<quint32> spanLogOffsets;
+    Column<quint32> children;
+    Column<qint64> logTimestamps;
+    Column<quint8> logLevels;
+    Column<quint8> logErrors;
+    Column<quint32> logFieldOffsets;
+    Column<quint32> valueKeys;
+    Column<quint8> valueTypes;
+    Column<qint64> valueData;
+};
+
+template<typename T>
+bool bind(QByteArrayView payload, const SectionEntry &entry, Column<T> *column)
+{
+    const auto payloadSize = static_cast<quint64>(payload.size());
+    if (entry.offset % 8 != 0 || entry.offset > payloadSize
+        || entry.size > payloadSize - entry.offset || entry.size % sizeof(T) != 0) {
+        return false;
+    }
+
+    column->data = reinterpret_cast<const T *>(payload.data() + entry.offset);
+    column->size = entry.size / sizeof(T);
+    return true;
+}
+
+bool bindColumns(QByteArrayView payload, quint32 sectionCount, Columns *c)
+{
+    if (sectionCount != static_cast<quint32>(SectionId::Count)
+        || sizeof(SectionEntry) * sectionCount > static_cast<quint64>(payload.size())) {
+        return false;
+    }
+
+    const auto *entries = reinterpret_cast<const SectionEntry *>(payload.data());
+    for (quint32 i = 0; i < sectionCount; ++i) {
+        const auto &e = entries[i];
+        bool ok = false;
+        switch (static_cast<SectionId>(e.id)) {
+        // clang-format off
+        case SectionId::StringOffsets: ok = bind(payload, e, &c->stringOffsets); break;
+        case SectionId::StringData: ok = bind(payload, e, &c->stringData); break;
+        case SectionId::Traces: ok = bind(payload, e, &c->traces); break;
+        case SectionId::Processes: ok = bind(payload, e, &c->processes); break;
+        case SectionId::SpanIDs: ok = bind(payload, e, &c->spanIDs); break;
+        case SectionId::SpanTraceIDs: ok = bind(payload, e, &c->spanTraceIDs); break;
+        case SectionId::SpanOperations: ok = bind(payload, e, &c->spanOperations); break;
+        case SectionId::SpanProcesses: ok = bind(payload, e, &c->spanProcesses); break;
+        case SectionId::SpanParents: ok = bind(payload, e, &c->spanParents); break;
+        case SectionId::SpanStartTimes: ok = bind(payload, e, &c->spanStartTimes); break;
+        case SectionId::SpanDurations: ok = bind(payload, e, &c->spanDurations); break;
+        case SectionId::SpanShifts: ok = bind(payload, e, &c->spanShifts); break;
+        case SectionId::SpanChildOffsets: ok = bind(payload, e, &c->spanChildOffsets); break;
+        case SectionId::SpanTagOffsets: ok = bind(payload, e, &c->spanTagOffsets); break;
+        case SectionId::SpanLogOffsets: ok = bind(payload, e, &c->spanLogOffsets); break;
+        case SectionId::Children: ok = bind(payload, e, &c->children); break;
+        case SectionId::LogTimestamps: ok = bind(payload, e, &c->logTimestamps); break;
+        case SectionId::LogLevels: ok = bind(payload, e, &c->logLevels); break;
+        case SectionId::LogErrors: ok = bind(payload, e, &c->logErrors); break;
+        case SectionId::LogFieldOffsets: ok = bind(payload, e, &c->logFieldOffsets); break;
+        case SectionId::ValueKeys: ok = bind(payload, e, &c->valueKeys); break;
+        case SectionId::ValueTypes: ok = bind(payload, e, &c->valueTypes); break;
+        case SectionId::ValueData: ok = bind(payload, e, &c->valueData); break;
+        case SectionId::Count: break;
+        // clang-format on
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//! count + 1 non-decreasing offsets from 0 to target
+template<typename T>
+bool validOffsets(const Column<T> &offsets, quint64 count, quint64 target)
+{
+    if (offsets.size != count + 1 || offsets[0] != 0 || offsets[count] != target) {
+        return false;
+    }
+
+    for (quint64 i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//! sizes of all columns agree with each other
+bool validColumns(const Columns &c)
+{
+    const auto strings = c.stringOffsets.size == 0 ? 0 : c.stringOffsets.size - 1;
+    const auto spans = c.spanIDs.size;
+    const auto logs = c.logTimestamps.size;
+    const auto values = c.valueKeys.size;
+
+    return strings != 0 && validOffsets(c.stringOffsets, strings, c.stringData.size)
+           && c.spanTraceIDs.size == spans && c.spanOperations.size == spans
+           && c.spanProcesses.size == spans && c.spanParents.size == spans
+           && c.spanStartTimes.size == spans && c.spanDurations.size == spans
+           && c.spanShifts.size == spans
+           && validOffsets(c.spanChildOffsets, spans, c.children.size)
+           && validOffsets(c.spanTagOffsets, spans, values)
+           && validOffsets(c.spanLogOffsets, spans, logs) && c.logLevels.size == logs
+           && c.logErrors.size == logs && validOffsets(c.logFieldOffsets, logs, values)
+           && c.valueTypes.size == values && c.valueData.size == values;
+}
+
+class Loader
+{
+public:
+    Loader(trace::SourcePtr source, const Columns &columns)
+        : m_source(std::move(source))
+        , m_c(columns)
+        , m_stringCount(columns.stringOffsets.size - 1)
+    {}
+
+    //! intern every string used as a name or a key, false on bad indices
+    bool internSymbols(int threadCount);
+
+    //! nullptr when the record points outside of the columns
+    std::shared_ptr<graph::Trace> makeTrace(const TraceRecord &record) const;
+
+private:
+    trace::StringRef string(quint64 index) const;
+
+    //! pool must have room for last - first values, it is never reallocated
+    template<typename T>
+    bool values(quint64 first,
+                quint64 last,
+                std::vector<T> *pool,
+                graph::Range<const T> *out) const;
+
+private:
+    trace::SourcePtr m_source;
+    const Columns &m_c;
+    quint64 m_stringCount;
+    std::vector<trace::Symbol> m_symbols;
+};
+
+trace::StringRef Loader::string(quint64 index) const
+{
+    const auto begin = m_c.stringOffsets[index];
+    const auto size = m_c.stringOffsets[index + 1] - begin;
+    return trace::StringRef::view(
+        QByteArrayView(m_c.stringData.data + begin, static_cast<qsizetype>(size)));
+}
+
+bool Loader::internSymbols(int threadCount)
+{
+    std::vector<quint8> used(m_stringCount, 0);
+    auto mark = [&](const Column<quint32> &column) {
+        for (quint64 i = 0; i < column.size; ++i) {
+            if (column[i] >= m_stringCount) {
+                return false;
+            }
+            used[column[i]] = 1;
+        }
+        return true;
+    };
+
+    if (!mark(m_c.spanOperations) || !mark(m_c.valueKeys)) {
+        return false;
+    }
+
+    for (quint64 i = 0; i < m_c.processes.size; ++i) {
+        if (m_c.processes[i].name >= m_stringCount) {
+            return false;
+        }
+        used[m_c.processes[i].name] = 1;
+    }
+
+    m_symbols.resize(m_stringCount);
+    trace::parallelFor(static_cast<qsizetype>(m_stringCount), threadCount, [&](qsizetype i) {
+        if (used[i] != 0) {
+            const auto utf8 = string(static_cast<quint64>(i)).utf8();
+            m_symbols[i] = trace::Symbol::intern(
+                std::string_view(utf8.data(), static_cast<size_t>(utf8.size())));
+        }
+    });
+
+    return true;
+}
+
+template<typename T>
+bool Loader::values(quint64 first,
+                    quint64 last,
+                    std::vector<T> *pool,
+                    graph::Range<const T> *out) const
+{
+    const auto start = pool->size();
+    for (auto i = first; i < last; ++i) {
+        T value;
+        value.key = m_symbols[m_c.valueKeys[i]];
+
+        const auto data = m_c.valueData[i];
+        const auto type = static_cast<ValueType>(m_c.valueTypes[i]);
+        switch (type) {
+        case ValueType::Null:
+            break;
+        case ValueType::String:
+        case ValueType::Binary:
+            if (data < 0 || static_cast<quint64>(data) >= m_stringCount) {
+                return false;
+            }
+            value.value = trace::Value::fromView(string(static_cast<quint64>(data)),
+                                                 type == ValueType::String
+                                                     ? trace::Value::Type::String
+                                                     : trace::Value::Type::Binary);
+            break;
+        case ValueType::Int64:
+            value.value = trace::Value::fromInt64(data);
+            break;
+        case ValueType::Bool:
+            value.value = trace::Value::fromBool(data != 0);
+            break;
+        case ValueType::Double: {
+            double number = 0;
+            std::memcpy(&number, &data, sizeof(number));
+            value.value = trace::Value::fromDouble(number);
+            break;
+        }
+        default:
+            return false;
+        }
+
+        pool->push_back(std::move(value));
+    }
+
+    *out = {pool->data() + start, pool->size() - start};
+    return true;
+}
+
+//! no span is reached twice walking children from the spans without a parent
+bool isTree(const graph::Trace &tr)
+{
+    std::vector<bool> visited(tr.spans.size());
+    std::vector<const graph::Span *> stack;
+    for (const auto &span : tr.spans) {
+        if (span.parent == nullptr) {
+            stack.push_back(&span);
+        }
+    }
+
+    while (!stack.empty()) {
+        const auto *span = stack.back();
+        stack.pop_back();
+
+        const auto index = static_cast<size_t>(span - tr.spans.data());
+        if (visited[index]) {
+            return false;
+        }
+        visited[index] = true;
+
+        stack.insert(stack.end(), span->children.begin(), span->children.end());
+    }
+
+    return true;
+}
+
+std::shared_ptr<graph::Trace> Loader::makeTrace(const TraceRecord &record) const
+{
+    const auto &c = m_c;
+    if (record.firstSpan > c.spanIDs.size
+        || record.spanCount > c.spanIDs.size - record.firstSpan
+        || record.firstProcess > c.processes.size
+        || record.processCount > c.processes.size - record.firstProcess
+        || (record.root != NoIndex && record.root >= record.spanCount)
+        || (record.root != NoIndex && c.spanParents[record.firstSpan + record.root] != NoIndex)) {
+        return nullptr;
+    }
+
+    auto tr = std::make_shared<graph::Trace>();
+    tr->traceID = trace::TraceID(record.traceID.high,
+                                 record.traceID.low,
+                                 record.traceID.wide != 0);
+    tr->source = m_source;
+
+    // every pool is reserved up front so the ranges stay valid
+    const quint64 firstSpan = record.firstSpan;
+    const quint64 lastSpan = firstSpan + record.spanCount;
+    const quint64 firstLog = c.spanLogOffsets[firstSpan];
+    const quint64 lastLog = c.spanLogOffsets[lastSpan];
+
+    quint64 tagCount = c.spanTagOffsets[lastSpan] - c.spanTagOffsets[firstSpan];
+    for (quint32 i = 0; i < record.processCount; ++i) {
+        const auto &rec = c.processes[record.firstProcess + i];
+        if (rec.firstTag > c.valueKeys.size || rec.tagCount > c.valueKeys.size - rec.firstTag) {
+            return nullptr;
+        }
+        tagCount += rec.tagCount;
+    }
+
+    tr->process.resize(record.processCount);
+    tr->spans.resize(record.spanCount);
+    tr->children.reserve(c.spanChildOffsets[lastSpan] - c.spanChildOffsets[firstSpan]);
+    tr->tags.reserve(tagCount);
+    tr->logs.reserve(lastLog - firstLog);
+    tr->fields.reserve(c.logFieldOffsets[lastLog] - c.logFieldOffsets[firstLog]);
+
+    for (quint32 i = 0; i < record.processCount; ++i) {
+        const auto &rec = c.processes[record.firstProcess + i];
+        auto &process = tr->process[i];
+        process.name = m_symbols[rec.name];
+        if (!values(rec.firstTag, quint64(rec.firstTag) + rec.tagCount, &tr->tags, &process.tags)) {
+            return nullptr;
+        }
+    }
+
+    for (quint32 i = 0; i < record.spanCount; ++i) {
+        const quint64 s = firstSpan + i;
+        auto &span = tr->spans[i];
+
+        if ((c.spanProcesses[s] != NoIndex && c.spanProcesses[s] >= record.processCount)
+            || (c.spanParents[s] != NoIndex && c.spanParents[s] >= record.spanCount)) {
+            return nullptr;
+        }
+
+        span.spanID = trace::SpanID(c.spanIDs[s]);
+        span.traceID = trace::TraceID(c.spanTraceIDs[s].high,
+                                      c.spanTraceIDs[s].low,
+                                      c.spanTraceIDs[s].wide != 0);
+        span.operationName = m_symbols[c.spanOperations[s]];
+        span.startTime = graph::TimePoint(std::chrono::microseconds(c.spanStartTimes[s]));
+        span.duration = std::chrono::microseconds(c.spanDurations[s]);
+        span.shift = std::chrono::microseconds(c.spanShifts[s]);
+
+        if (c.spanProcesses[s] != NoIndex) {
+            span.process = &tr->process[c.spanProcesses[s]];
+        }
+        if (c.spanParents[s] != NoIndex) {
+            span.parent = &tr->spans[c.spanParents[s]];
+        }
+
+        const auto firstChild = tr->children.size();
+        for (auto child = c.spanChildOffsets[s]; child < c.spanChildOffsets[s + 1]; ++child) {
+            // a child must point back to its parent, the checksum does not stop crafted files
+            if (c.children[child] >= record.spanCount
+                || c.spanParents[firstSpan + c.children[child]] != i) {
+                return nullptr;
+            }
+            tr->children.push_back(&tr->spans[c.children[child]]);
+        }
+        span.children = {tr->children.data() + firstChild, tr->children.size() - firstChild};
+
+        if (!values(c.spanTagOffsets[s], c.spanTagOffsets[s + 1], &tr->tags, &span.tags)) {
+            return nullptr;
+        }
+
+        const auto spanFirstLog = tr->logs.size();
+        for (auto log = c.spanLogOffsets[s]; log < c.spanLogOffsets[s + 1]; ++log) {
+            if (c.logLevels[log] > static_cast<quint8>(graph::LogRecord::Level::Fatal)) {
+                return nullptr;
+            }
+
+            graph::LogRecord rec;
+            rec.timestamp = graph::TimePoint(std::chrono::microseconds(c.logTimestamps[log]));
+            rec.level = static_cast<graph::LogRecord::Level>(c.logLevels[log]);
+            rec.hasError = c.logErrors[log] != 0;
+            if (!values(c.logFieldOffsets[log],
+                        c.logFieldOffsets[log + 1],
+                        &tr->fields,
+                        &rec.fields)) {
+                return nullptr;
+            }
+            tr->logs.push_back(rec);
+        }
+        span.logs = {tr->logs.data() + spanFirstLog, tr->logs.size() - spanFirstLog};
+    }
+
+    if (record.root != NoIndex) {
+        tr->root = &tr->spans[record.root];
+    }
+
+    // a child listed twice would be walked twice by every pass over the trace
+    if (!isTree(*tr)) {
+        return nullptr;
+    }
+
+    tr->computeMetrics();
+
+    return tr;
+}
+
+} // namespace
+
+namespace graph {
+
+bool Snapshot::isSnapshot(QByteArrayView data) noexcept
+{
+    return data.size() >= qsizetype(sizeof(Header))
+           && std::memcmp(data.data(), Magic, sizeof(Magic)) == 0;
+}
+
+bool Snapshot::save(const TraceGraph &graph, const QString &fileName, SnapshotError *error)
+{
+    Writer writer;
+    if (!writer.add(graph)) {
+        qWarning() << "trace graph is too large for snapshot";
+        setError(error, SnapshotError::Error::InvalidFormat);
+        return false;
+    }
+
+    const auto payload = writer.payload();
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrder = ByteOrderMark;
+    header.payloadSize = static_cast<quint64>(payload.size());
+    header.checksum = checksum(payload);
+    header.sectionCount = static_cast<quint32>(SectionId::Count);
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "failed open snapshot" << fileName << file.errorString();
+        setError(error, SnapshotError::Error::IOError);
+        return false;
+    }
+
+    if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+        || file.write(payload) != payload.size() || !file.commit()) {
+        qWarning() << "failed write snapshot" << fileName << file.errorString();
+        setError(error, SnapshotError::Error::IOError);
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<TraceGraph> Snapshot::load(const trace::SourcePtr &source,
+                                           SnapshotError *error,
+                                           int threadCount)
+{
+    const auto data = source->data();
+    if (!isSnapshot(data)) {
+        setError(error, SnapshotError::Error::InvalidFormat);
+        return nullptr;
+    }
+
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.version != Version || header.byteOrder != ByteOrderMark) {
+        qWarning() << "unsupported snapshot version" << header.version;
+        setError(error, SnapshotError::Error::UnsupportedVersion);
+        return nullptr;
+    }
+
+    const auto payload = data.sliced(sizeof(Header));
+    if (header.payloadSize != static_cast<quint64>(payload.size())) {
+        setError(error, SnapshotError::Error::InvalidFormat);
+        return nullptr;
+    }
+
+    if (header.checksum != checksum(payload)) {
+        setError(error, SnapshotError::Error::ChecksumMismatch);
+        return nullptr;
+    }
+
+    Columns columns;
+    if (!bindColumns(payload, header.sectionCount, &columns) || !validColumns(columns)) {
+        qWarning() << "invalid snapshot layout";
+        setError(error, SnapshotError::Error::InvalidFormat);
+        return nullptr;
+    }
+
+    Loader loader(source, columns);
+    if (!loader.internSymbols(threadCount)) {
+        setError(error, SnapshotError::Error::InvalidFormat);
+        return nullptr;
+    }
+
+    auto traceGraph = std::make_shared<TraceGraph>();
+    traceGraph->traces.resize(columns.traces.size);
+
+    std::atomic<bool> valid{true};
+    auto traces = traceGraph->traces.data();
+    trace::parallelFor(static_cast<qsizetype>(columns.traces.size), threadCount, [&](qsizetype i) {
+        traces[i] = loader.makeTrace(columns.traces[static_cast<quint64>(i)]);
+        if (!traces[i]) {
+            valid = false;
+        }
+    });
+
+    if (!valid) {
+        qWarning() << "invalid snapshot indices";
+        setError(error, SnapshotError::Error::InvalidFormat);
+        return nullptr;
+    }
+
+    traceGraph->mergeLatency();
+    return traceGraph;
+}
+
+std::shared_ptr<TraceGraph> Snapshot::load(const QString &fileName,
+                                           SnapshotError *error,
+                                           int threadCount)
+{
+    QString errorString;
+    const auto source = trace::Source::mapFile(fileName, &errorString);
+    if (!source) {
+        qWarning() << "failed open snapshot" << fileName << errorString;
+        setError(error, SnapshotError::Error::IOError);
+        return nullptr;
+    }
+
+    return load(source, error, threadCount);
+}
+
+QString SnapshotError::errorString() const
+{
+    switch (error) {
+    case Error::NoError:
+        return QLatin1String("not error");
+    case Error::IOError:
+        return QLatin1String("snapshot read or write failed");
+    case Error::InvalidFormat:
+        return QLatin1String("invalid snapshot");
+    case Error::UnsupportedVersion:
+        return QLatin1String("unsupported snapshot version");
+    case Error::ChecksumMismatch:
+        return QLatin1String("snapshot checksum mismatch");
+    }
+
+    return QString();
+}
+
+} // namespace graph
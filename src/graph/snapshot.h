@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+
+#include <QtCore/QByteArrayView>
+#include <QtCore/QString>
+
+#include "trace/source.h"
+
+#include "trace.h"
+
+namespace graph {
+
+struct SnapshotError
+{
+    enum class Error {
+        NoError,
+        IOError,
+        InvalidFormat,
+        UnsupportedVersion,
+        ChecksumMismatch,
+    };
+
+    Error error = Error::NoError;
+
+    QString errorString() const;
+};
+
+/*!
+ * Binary columnar copy of a TraceGraph.
+ *
+ * Span, log and tag fields are stored column by column together with parent
+ * and child indices, strings are deduplicated into one table. Loading maps
+ * the file and builds the graph straight from the columns: string values
+ * stay views into the mapping, names are interned once per distinct string
+ * and no JSON is parsed.
+ *
+ * The file starts with a versioned header holding a checksum of everything
+ * after it. Integers are written in host byte order, files from a host with
+ * another byte order are rejected.
+ */
+struct Snapshot
+{
+    static constexpr quint32 Version = 3;
+
+    static bool isSnapshot(QByteArrayView data) noexcept;
+
+    static bool save(const TraceGraph &graph,
+                     const QString &fileName,
+                     SnapshotError *error = nullptr);
+
+    static std::shared_ptr<TraceGraph> load(const trace::SourcePtr &source,
+                                            SnapshotError *error = nullptr,
+                                            int threadCount = 1);
+    static std::shared_ptr<TraceGraph> load(const QString &fileName,
+                                            SnapshotError *error = nullptr,
+                                            int threadCount = 1);
+};
+
+} // namespace graph
@@ -1,10 +1,15 @@
 #pragma once
 
 #include <chrono>
-#include <vector>
 
+#include <QtCore/QByteArrayView>
 #include <QtCore/QString>
 
+#include "trace/id.h"
+#include "trace/span.h"
+#include "trace/string_ref.h"
+
+#include "range.h"
 #include "tag.h"
 
 namespace graph {
@@ -16,32 +21,53 @@ struct LogRecord
 {
     enum class Level { No, Debug, Info, Warn, Error, Panic, Fatal };
 
-    struct Field
-    {
-        QString key;
-        QVariant value;
-    };
+    using Field = trace::LogRecord::Field;
 
     TimePoint timestamp;
     //!< level we take from fields by 'level' field
     Level level = Level::No;
     bool hasError = false;
-    QVector<Field> fields;
+    //! fields of a snapshot, logs of a JSON trace keep rawFields instead
+    Range<const Field> fields;
+    //! undecoded 'fields' array inside the trace source
+    QByteArrayView rawFields;
+
+    //! fields without 'level', decoded from rawFields on every call, escaped strings are kept
+    //! by keeper
+    QVector<Field> decodeFields(const trace::Source &keeper) const;
 };
 
 struct Span
 {
     Span *parent = nullptr;
-    std::vector<Span *> children;
-    QString traceID;
-    QString spanID;
-    QString operationName;
+    Range<Span *const> children;
+    trace::TraceID traceID;
+    trace::SpanID spanID;
+    trace::Symbol operationName;
     TimePoint startTime;
     std::chrono::microseconds duration;
     std::chrono::microseconds shift; // startTime - root.startTime
     Process *process = nullptr;
-    Tags tags;
-    QVector<LogRecord> logs;
+    Range<const Tag> tags;
+    Range<const LogRecord> logs;
+
+    //! derived by Trace::computeMetrics
+    std::chrono::microseconds selfTime{0}; // duration not covered by children
+    quint32 depth = 0;
+    quint32 descendantCount = 0;
+    //! preorder number in the trace, descendants are numbered in [enter + 1, exit)
+    quint32 enter = 0;
+    quint32 exit = 0;
+    //! equal for subtrees of the same services and operations, whatever the order of children
+    size_t shapeHash = 0;
+    bool hasError = false; // error tag or error log on the span itself
+    bool subtreeHasError = false;
+
+    //! other is this span or one of its descendants, both spans of one trace
+    bool contains(const Span &other) const noexcept
+    {
+        return enter <= other.enter && other.enter < exit;
+    }
 };
 
 } // namespace graph
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <algorithm>
+
+#include "span_group.h"
+
+namespace graph {
+
+std::chrono::microseconds SpanGroup::averageDuration() const noexcept
+{
+    return count != 0 ? totalDuration / count : std::chrono::microseconds(0);
+}
+
+std::vector<SpanGroup> SpanGroup::collapse(const std::vector<const Span *> &spans)
+{
+    std::vector<SpanGroup> groups;
+    for (size_t i = 0; i < spans.size(); ++i) {
+        const auto *span = spans[i];
+        if (groups.empty() || spans[groups.back().first]->parent != span->parent
+            || spans[groups.back().first]->shapeHash != span->shapeHash) {
+            groups.push_back({i, 0, span->duration, span->duration});
+        }
+
+        auto &group = groups.back();
+        ++group.count;
+        group.minDuration = std::min(group.minDuration, span->duration);
+        group.maxDuration = std::max(group.maxDuration, span->duration);
+        group.totalDuration += span->duration;
+    }
+
+    return groups;
+}
+
+std::vector<SpanGroup> SpanGroup::collapseChildren(const Span &span,
+                                                   std::vector<const Span *> *children)
+{
+    children->clear();
+    for (const auto *child : span.children) {
+        if (child->parent == &span) {
+            children->push_back(child);
+        }
+    }
+
+    std::stable_sort(children->begin(), children->end(), [](const Span *a, const Span *b) {
+        return a->startTime < b->startTime;
+    });
+    return collapse(*children);
+}
+
+} // namespace graph
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "span.h"
+
+namespace graph {
+
+/*!
+ * Run of sibling subtrees of the same shape, e.g. the queries of an N+1 loop.
+ *
+ * Spans in order of start time that share their parent and Span::shapeHash
+ * collapse into one group that keeps the count and the duration range, so
+ * views show one row per run instead of one per copy.
+ */
+struct SpanGroup
+{
+    //! index of the first span of the run in the collapsed spans
+    size_t first = 0;
+    quint32 count = 0;
+    std::chrono::microseconds minDuration{0};
+    std::chrono::microseconds maxDuration{0};
+    std::chrono::microseconds totalDuration{0};
+
+    std::chrono::microseconds averageDuration() const noexcept;
+
+    //! spans ordered by start time, consecutive ones of one parent and shape share a group
+    static std::vector<SpanGroup> collapse(const std::vector<const Span *> &spans);
+    //! children of the span ordered by start time and collapsed
+    static std::vector<SpanGroup> collapseChildren(const Span &span,
+                                                   std::vector<const Span *> *children);
+};
+
+} // namespace graph
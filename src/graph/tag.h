@@ -1,16 +1,11 @@
 #pragma once
 
-#include <QtCore/QString>
-#include <QtCore/QVariant>
-#include <QtCore/QVector>
+#include "trace/tag.h"
 
 namespace graph {
-struct Tag
-{
-    QString key;
-    QVariant value;
-};
 
-using Tags = QVector<Tag>;
+//! same representation as the parser, tags move into the graph without a copy
+using Tag = trace::Tag;
+using Tags = trace::Tags;
 
 } // namespace graph
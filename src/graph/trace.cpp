@@ -1,24 +1,19 @@
-#include "trace.h"
+#include <algorithm>
+#include <type_traits>
+#include <utility>
 
-namespace {
+#include <QtCore/QThreadPool>
 
-graph::Tags copyTags(const trace::Tags &tags)
-{
-    graph::Tags tgs;
-    tgs.reserve(tags.size());
-    for (const auto &tag : tags) {
-        graph::Tag gTag;
-        gTag.key = tag.key;
-        gTag.value = tag.value;
-        tgs.emplace_back(gTag);
-    }
+#include "trace/id_map.h"
+#include "trace/parallel.h"
 
-    return tgs;
-}
+#include "trace.h"
+
+namespace {
 
-graph::LogRecord::Level logLevel(const QString &level)
+graph::LogRecord::Level logLevel(QByteArrayView level)
 {
-    static const QHash<QString, graph::LogRecord::Level> levels = {
+    static const std::pair<QByteArrayView, graph::LogRecord::Level> levels[] = {
         {"debug", graph::LogRecord::Level::Debug},
         {"info", graph::LogRecord::Level::Info},
         {"warn", graph::LogRecord::Level::Warn},
@@ -28,89 +23,123 @@ graph::LogRecord::Level logLevel(const QString &level)
         {"fatal", graph::LogRecord::Level::Fatal},
     };
 
-    return levels.value(level, graph::LogRecord::Level::No);
+    for (const auto &[name, value] : levels) {
+        if (level.compare(name, Qt::CaseInsensitive) == 0) {
+            return value;
+        }
+    }
+
+    return graph::LogRecord::Level::No;
 };
 
-QVector<graph::LogRecord> copyLogs(const QVector<trace::LogRecord> &logs)
+static_assert(std::is_trivially_destructible_v<graph::Span>
+                  && std::is_trivially_destructible_v<graph::Process>
+                  && std::is_trivially_destructible_v<graph::Tag>
+                  && std::is_trivially_destructible_v<graph::LogRecord>,
+              "a trace is released by freeing its pools");
+
+//! bijective, sums of mixed child shapes do not cancel out like plain xor
+quint64 mixShape(quint64 value)
 {
-    QVector<graph::LogRecord> lgs;
-    lgs.reserve(logs.size());
+    value += 0x9e3779b97f4a7c15;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+    return value ^ (value >> 31);
+}
+
+graph::Range<const graph::Tag> appendTags(std::vector<graph::Tag> &pool, const trace::Tags &tags)
+{
+    const auto first = pool.size();
+    pool.insert(pool.end(), tags.cbegin(), tags.cend());
+    return {pool.data() + first, static_cast<size_t>(tags.size())};
+}
 
+//! fields stay in the source, the pool must have room for every record
+graph::Range<const graph::LogRecord> appendLogs(std::vector<graph::LogRecord> &pool,
+                                                const QVector<trace::LogRecord> &logs)
+{
+    const auto first = pool.size();
     for (const auto &record : logs) {
         graph::LogRecord rec;
         rec.timestamp = record.timestamp;
-        rec.fields.reserve(record.fields.size());
-
-        for (const auto &field : record.fields) {
-            if (field.key != "level") {
-                graph::LogRecord::Field f;
-                f.key = field.key;
-                f.value = field.value;
-                rec.fields.emplace_back(f);
-                if (field.key == "error") {
-                    rec.hasError = true;
-                }
-                continue;
-            }
-
-            if (field.key == "level") {
-                rec.level = logLevel(field.value.toString().toLower());
-            }
-        }
-
-        lgs.emplace_back(rec);
+        rec.level = logLevel(record.level);
+        rec.hasError = record.hasError;
+        rec.rawFields = record.rawFields;
+        pool.push_back(rec);
     }
 
-    return lgs;
+    return {pool.data() + first, static_cast<size_t>(logs.size())};
 }
 
 using TracePtr = std::shared_ptr<graph::Trace>;
 
-TracePtr makeTrace(const trace::Trace &rawTrace)
+//! the source moves out of rawTrace, tags are copied into the pool of the trace
+TracePtr makeTrace(trace::Trace &&rawTrace)
 {
     auto tracePtr = std::make_shared<graph::Trace>();
-    tracePtr->traceID = rawTrace.traceID;
-    tracePtr->spans.reserve(rawTrace.spans.size());
-    tracePtr->process.reserve(rawTrace.process.size());
+    auto &tr = *tracePtr;
+    tr.traceID = rawTrace.traceID;
+    tr.source = std::move(rawTrace.source);
 
-    QHash<QString, graph::Process *> processMap;
-    processMap.reserve(rawTrace.process.size());
+    const auto &rawSpans = std::as_const(rawTrace.spans);
+    const auto spanCount = static_cast<size_t>(rawSpans.size());
+
+    qsizetype tagCount = 0;
+    qsizetype logCount = 0;
+    for (const auto &process : std::as_const(rawTrace.process)) {
+        tagCount += process.tags.size();
+    }
+    for (const auto &span : rawSpans) {
+        tagCount += span.tags.size();
+        logCount += span.logs.size();
+    }
+    tr.tags.reserve(static_cast<size_t>(tagCount));
+    tr.logs.reserve(static_cast<size_t>(logCount));
 
-    for (auto processIter = rawTrace.process.begin(); processIter != rawTrace.process.end();
-         ++processIter) {
-        auto process = std::make_unique<graph::Process>();
+    tr.process.resize(static_cast<size_t>(rawTrace.process.size()));
+    QHash<trace::StringRef, graph::Process *> processMap;
+    processMap.reserve(rawTrace.process.size());
 
+    auto *process = tr.process.data();
+    for (auto processIter = rawTrace.process.cbegin(); processIter != rawTrace.process.cend();
+         ++processIter, ++process) {
         process->name = processIter->name;
-        processMap[processIter.key()] = process.get();
-        process->tags = copyTags(processIter->tags);
-        tracePtr->process.emplace_back(std::move(process));
+        process->tags = appendTags(tr.tags, processIter->tags);
+        processMap.insert(processIter.key(), process);
     }
 
-    QHash<QString, graph::Span *> spanMap;
-    spanMap.reserve(rawTrace.spans.size());
+    tr.spans.resize(spanCount);
+    trace::SpanIDMap<graph::Span *> spanMap(spanCount);
 
-    for (auto spanIter = rawTrace.spans.begin(); spanIter != rawTrace.spans.end(); ++spanIter) {
-        auto span = std::make_unique<graph::Span>();
+    for (size_t i = 0; i < spanCount; ++i) {
+        const auto &rawSpan = rawSpans[static_cast<qsizetype>(i)];
+        auto &span = tr.spans[i];
 
-        span->spanID = spanIter->spanID;
-        span->operationName = spanIter->operationName;
-        span->startTime = spanIter->startTime;
-        span->duration = spanIter->duration;
-        span->process = processMap.value(spanIter->processID, nullptr);
-        span->tags = copyTags(spanIter->tags);
-        span->logs = copyLogs(spanIter->logs);
+        span.traceID = rawSpan.traceID;
+        span.spanID = rawSpan.spanID;
+        span.operationName = rawSpan.operationName;
+        span.startTime = rawSpan.startTime;
+        span.duration = rawSpan.duration;
+        span.process = processMap.value(rawSpan.processID, nullptr);
+        span.tags = appendTags(tr.tags, rawSpan.tags);
+        span.logs = appendLogs(tr.logs, rawSpan.logs);
 
-        spanMap.insert(span->spanID, span.get());
-        tracePtr->spans.emplace_back(std::move(span));
+        spanMap.insert(span.spanID, &span);
     }
 
-    for (auto spanIter = rawTrace.spans.begin(); spanIter != rawTrace.spans.end(); ++spanIter) {
-        auto span = spanMap[spanIter->spanID];
-        if (spanIter->references.empty()) {
-            tracePtr->root = span;
+    // parent, child pairs are grouped by parent into the adjacency array
+    std::vector<std::pair<quint32, graph::Span *>> edges;
+    edges.reserve(spanCount);
+    std::vector<quint32> offsets(spanCount + 1, 0);
+
+    for (size_t i = 0; i < spanCount; ++i) {
+        const auto &rawSpan = rawSpans[static_cast<qsizetype>(i)];
+        auto &span = tr.spans[i];
+        if (rawSpan.references.empty()) {
+            tr.root = &span;
         }
 
-        for (const auto &ref : spanIter->references) {
+        for (const auto &ref : rawSpan.references) {
             if (ref.refType == trace::SpanReference::Type::ChildOf) {
                 auto parent = spanMap.value(ref.spanID, nullptr);
                 if (parent == nullptr) {
@@ -118,18 +147,47 @@ TracePtr makeTrace(const trace::Trace &rawTrace)
                     continue;
                 }
 
-                parent->children.push_back(span);
-                span->parent = parent;
+                span.parent = parent;
             }
         }
+
+        // a span is a child of its parent only, walks down the tree never meet it twice
+        if (span.parent != nullptr) {
+            const auto parentIndex = static_cast<quint32>(span.parent - tr.spans.data());
+            edges.emplace_back(parentIndex, &span);
+            ++offsets[parentIndex + 1];
+        }
     }
-    for (auto spanIter = rawTrace.spans.begin(); spanIter != rawTrace.spans.end(); ++spanIter) {
-        auto span = spanMap[spanIter->spanID];
-        if (span != tracePtr->root) {
-            span->shift = span->startTime - tracePtr->root->startTime;
+
+    // every span names a parent, the first one whose parent is missing stands for the root
+    if (tr.root == nullptr) {
+        const auto orphan = std::find_if(tr.spans.begin(), tr.spans.end(), [](const auto &span) {
+            return span.parent == nullptr;
+        });
+        if (orphan != tr.spans.end()) {
+            tr.root = &*orphan;
+        }
+    }
+
+    for (size_t i = 0; i < spanCount; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    tr.children.resize(edges.size());
+    auto next = offsets;
+    for (const auto &[parentIndex, child] : edges) {
+        tr.children[next[parentIndex]++] = child;
+    }
+
+    for (size_t i = 0; i < spanCount; ++i) {
+        auto &span = tr.spans[i];
+        span.children = {tr.children.data() + offsets[i], offsets[i + 1] - offsets[i]};
+        if (tr.root != nullptr && &span != tr.root) {
+            span.shift = span.startTime - tr.root->startTime;
         }
     }
 
+    tr.computeMetrics();
     return tracePtr;
 };
 
@@ -137,15 +195,249 @@ TracePtr makeTrace(const trace::Trace &rawTrace)
 
 namespace graph {
 
-std::shared_ptr<TraceGraph> TraceGraph::makeGraph(const trace::TraceDocument &document)
+QVector<LogRecord::Field> LogRecord::decodeFields(const trace::Source &keeper) const
+{
+    static const auto levelKey = trace::Symbol::intern("level");
+
+    auto decoded = rawFields.isEmpty() ? QVector<Field>(fields.begin(), fields.end())
+                                       : trace::LogRecord::parseFields(keeper, rawFields);
+    decoded.removeIf([](const Field &field) { return field.key == levelKey; });
+    return decoded;
+}
+
+void Trace::computeMetrics()
+{
+    static const auto errorKey = trace::Symbol::intern("error");
+
+    // preorder from every span without parent, a span is visited from its parent only
+    std::vector<Span *> order;
+    order.reserve(spans.size());
+    std::vector<Span *> stack;
+    for (auto &span : spans) {
+        // spans on a reference cycle are never visited and contain nothing
+        span.enter = span.exit = static_cast<quint32>(spans.size());
+        if (span.parent == nullptr) {
+            span.depth = 0;
+            stack.push_back(&span);
+        }
+    }
+
+    while (!stack.empty()) {
+        auto *span = stack.back();
+        stack.pop_back();
+        span->enter = static_cast<quint32>(order.size());
+        order.push_back(span);
+        for (auto *child : span->children) {
+            if (child->parent == span) {
+                child->depth = span->depth + 1;
+                stack.push_back(child);
+            }
+        }
+    }
+
+    std::vector<std::pair<TimePoint, TimePoint>> intervals;
+    for (auto iter = order.rbegin(); iter != order.rend(); ++iter) {
+        auto &span = **iter;
+        const auto end = span.startTime + span.duration;
+
+        span.hasError = std::any_of(span.tags.begin(), span.tags.end(), [](const Tag &tag) {
+            return tag.key == errorKey && tag.value.toBool();
+        });
+        span.hasError = span.hasError
+                        || std::any_of(span.logs.begin(), span.logs.end(), [](const auto &log) {
+                               return log.hasError;
+                           });
+        span.subtreeHasError = span.hasError;
+        span.descendantCount = 0;
+
+        intervals.clear();
+        quint64 childShapes = 0;
+        for (const auto *child : span.children) {
+            if (child->parent != &span) {
+                continue;
+            }
+
+            childShapes += mixShape(child->shapeHash);
+            span.descendantCount += child->descendantCount + 1;
+            span.subtreeHasError = span.subtreeHasError || child->subtreeHasError;
+
+            const auto childBegin = std::clamp(child->startTime, span.startTime, end);
+            const auto childEnd = std::clamp(child->startTime + child->duration, childBegin, end);
+            if (childBegin < childEnd) {
+                intervals.emplace_back(childBegin, childEnd);
+            }
+        }
+
+        // union of the children, overlapping ones are counted once
+        std::sort(intervals.begin(), intervals.end());
+        std::chrono::microseconds covered(0);
+        auto cursor = span.startTime;
+        for (const auto &[childBegin, childEnd] : intervals) {
+            if (childEnd > cursor) {
+                covered += childEnd - std::max(childBegin, cursor);
+                cursor = childEnd;
+            }
+        }
+
+        span.selfTime = span.duration - covered;
+        span.exit = span.enter + span.descendantCount + 1;
+
+        const auto service = span.process != nullptr ? span.process->name : trace::Symbol();
+        span.shapeHash = qHashMulti(childShapes, service, span.operationName);
+    }
+
+    latency = LatencyStats();
+    latency.add(*this);
+}
+
+const IntervalIndex &Trace::intervals()
+{
+    std::call_once(m_intervalsBuilt, [this]() { m_intervals = IntervalIndex(*this); });
+    return m_intervals;
+}
+
+void TraceGraph::mergeLatency()
+{
+    latency = LatencyStats();
+    for (const auto &tr : traces) {
+        if (tr) {
+            latency.merge(tr->latency);
+        }
+    }
+}
+
+std::shared_ptr<TraceGraph> TraceGraph::makeGraph(const trace::TraceDocument &document,
+                                                  int threadCount)
+{
+    return makeGraph(trace::TraceDocument(document), threadCount);
+}
+
+std::shared_ptr<TraceGraph> TraceGraph::makeGraph(trace::TraceDocument &&document,
+                                                  int threadCount)
+{
+    auto traceGraph = std::make_shared<TraceGraph>();
+
+    traceGraph->traces.resize(document.traces.size());
+    auto traces = traceGraph->traces.data();
+    // detach once here, workers move their trace out
+    auto rawTraces = document.traces.data();
+    trace::parallelFor(document.traces.size(), threadCount, [&](qsizetype i) {
+        traces[i] = makeTrace(std::move(rawTraces[i]));
+    });
+    document.traces.clear();
+    traceGraph->mergeLatency();
+
+    return traceGraph;
+}
+
+std::shared_ptr<TraceGraph> TraceGraph::parseGraph(const QByteArray &data,
+                                                   trace::TraceParseError *error,
+                                                   int threadCount)
+{
+    return parseGraph(trace::Source::fromData(data), error, threadCount);
+}
+
+std::shared_ptr<TraceGraph> TraceGraph::parseGraph(const trace::SourcePtr &source,
+                                                   trace::TraceParseError *error,
+                                                   int threadCount)
+{
+    trace::TraceParseError splitError;
+    const auto rawTraces = trace::TraceDocument::split(source->data(), &splitError);
+    if (splitError.error != trace::TraceParseError::ParseError::NoError) {
+        if (error != nullptr) {
+            error->error = splitError.error;
+        }
+        return nullptr;
+    }
+
+    auto traceGraph = std::make_shared<TraceGraph>();
+    traceGraph->traces.resize(rawTraces.size());
+    std::vector<trace::TraceParseError> errors(rawTraces.size());
+
+    auto traces = traceGraph->traces.data();
+    auto traceErrors = errors.data();
+    trace::parallelFor(rawTraces.size(), threadCount, [&](qsizetype i) {
+        auto rawTrace = trace::Trace::parse(source, rawTraces[i], &traceErrors[i]);
+        if (traceErrors[i].error == trace::TraceParseError::ParseError::NoError) {
+            traces[i] = makeTrace(std::move(rawTrace));
+        }
+    });
+
+    for (const auto &err : errors) {
+        if (err.error != trace::TraceParseError::ParseError::NoError) {
+            if (error != nullptr) {
+                error->error = err.error;
+            }
+            return nullptr;
+        }
+    }
+
+    traceGraph->mergeLatency();
+    return traceGraph;
+}
+
+TraceGraphBuilder::TraceGraphBuilder(int threadCount)
+{
+    if (threadCount > 1) {
+        m_pool = std::make_unique<QThreadPool>();
+        m_pool->setMaxThreadCount(threadCount);
+    }
+}
+
+TraceGraphBuilder::~TraceGraphBuilder()
+{
+    if (m_pool) {
+        m_pool->waitForDone();
+    }
+}
+
+void TraceGraphBuilder::append(QByteArrayView chunk)
+{
+    for (auto &rawTrace : m_stream.append(chunk)) {
+        // deque keeps the slot in place while more traces are appended
+        auto *slot = &m_slots.emplace_back();
+        auto parse = [slot, rawTrace = std::move(rawTrace)]() {
+            const auto source = trace::Source::fromData(rawTrace);
+            auto tr = trace::Trace::parse(source, source->data(), &slot->error);
+            if (slot->error.error == trace::TraceParseError::ParseError::NoError) {
+                slot->trace = makeTrace(std::move(tr));
+            }
+        };
+
+        if (m_pool) {
+            m_pool->start(std::move(parse));
+        } else {
+            parse();
+        }
+    }
+}
+
+std::shared_ptr<TraceGraph> TraceGraphBuilder::finish(trace::TraceParseError *error)
 {
+    if (m_pool) {
+        m_pool->waitForDone();
+    }
+
+    if (!m_stream.finish(error)) {
+        return nullptr;
+    }
+
     auto traceGraph = std::make_shared<TraceGraph>();
+    traceGraph->traces.reserve(m_slots.size());
+    for (auto &slot : m_slots) {
+        if (slot.error.error != trace::TraceParseError::ParseError::NoError) {
+            if (error != nullptr) {
+                error->error = slot.error.error;
+            }
+            return nullptr;
+        }
 
-    traceGraph->traces.reserve(document.traces.size());
-    for (const auto &trace : document.traces) {
-        traceGraph->traces.emplace_back(makeTrace(trace));
+        traceGraph->traces.push_back(std::move(slot.trace));
     }
+    m_slots.clear();
+    traceGraph->mergeLatency();
+
     return traceGraph;
 }
 
-} // namespace graph
\ No newline at end of file
+} // namespace graph
@@ -1,28 +1,120 @@
 #pragma once
 
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "trace/trace.h"
+#include "trace/trace_stream.h"
 
+#include "interval_index.h"
+#include "latency.h"
 #include "process.h"
 #include "span.h"
 
+class QThreadPool;
+
 namespace graph {
 
+/*!
+ * Spans and processes of a trace are stored contiguously, the ranges they
+ * hold point into pools shared by the whole trace. Nothing is reallocated
+ * once the trace is built, so the pointers stay valid, and every element
+ * is trivially destructible: releasing a trace frees a handful of blocks.
+ */
 struct Trace
 {
-    QString traceID;
-    Span *root;
+    trace::TraceID traceID;
+    Span *root = nullptr;
+
+    std::vector<Span> spans;
+    std::vector<Process> process;
+
+    //! children of every span grouped by parent
+    std::vector<Span *> children;
+    std::vector<Tag> tags;
+    std::vector<LogRecord> logs;
+    //! fields of the logs of a snapshot, see LogRecord::fields
+    std::vector<LogRecord::Field> fields;
+
+    //! owns the bytes that tag strings and raw log fields point to
+    trace::SourcePtr source;
 
-    std::vector<std::unique_ptr<Span>> spans;
-    std::vector<std::unique_ptr<Process>> process;
+    //! durations of the spans of this trace, see TraceGraph::latency
+    LatencyStats latency;
+
+    //! span is one of spans, traces of a graph may share their ID
+    bool owns(const Span &span) const noexcept
+    {
+        const std::less<const Span *> less;
+        return !less(&span, spans.data()) && less(&span, spans.data() + spans.size());
+    }
+
+    //! fill derived fields of every span in one post-order pass and the latency of the trace
+    void computeMetrics();
+    //! built on first call, other callers wait for it
+    const IntervalIndex &intervals();
+
+private:
+    std::once_flag m_intervalsBuilt;
+    IntervalIndex m_intervals;
 };
 
 struct TraceGraph
 {
     std::vector<std::shared_ptr<Trace>> traces;
+    //! merged from the traces once they are built
+    LatencyStats latency;
+
+    //! merge latency of every trace into latency, builders call it at the end
+    void mergeLatency();
+
+    //! copies the document, prefer the overload that consumes it
+    static std::shared_ptr<TraceGraph> makeGraph(const trace::TraceDocument &document,
+                                                 int threadCount = 1);
+    //! tags, logs and sources move into the graph, document is left empty
+    static std::shared_ptr<TraceGraph> makeGraph(trace::TraceDocument &&document,
+                                                 int threadCount = 1);
+
+    //! parse every trace of the document and build its graph in one task on threadCount workers
+    static std::shared_ptr<TraceGraph> parseGraph(const QByteArray &data,
+                                                  trace::TraceParseError *error,
+                                                  int threadCount);
+    static std::shared_ptr<TraceGraph> parseGraph(const trace::SourcePtr &source,
+                                                  trace::TraceParseError *error,
+                                                  int threadCount);
+};
+
+/*!
+ * Builds a TraceGraph from a search result that arrives in chunks.
+ *
+ * Every trace is parsed on one of threadCount workers as soon as its last
+ * byte is appended, so parsing overlaps with the download. Each trace gets
+ * a Source of its own.
+ */
+class TraceGraphBuilder
+{
+public:
+    explicit TraceGraphBuilder(int threadCount = 1);
+    ~TraceGraphBuilder();
+
+    void append(QByteArrayView chunk);
+
+    //! wait for the workers, nullptr when the document or one of its traces is invalid
+    std::shared_ptr<TraceGraph> finish(trace::TraceParseError *error = nullptr);
+
+private:
+    struct Slot
+    {
+        std::shared_ptr<Trace> trace;
+        trace::TraceParseError error;
+    };
 
-    static std::shared_ptr<TraceGraph> makeGraph(const trace::TraceDocument &document);
+    trace::TraceStream m_stream;
+    std::deque<Slot> m_slots;
+    std::unique_ptr<QThreadPool> m_pool;
 };
 
 } // namespace graph
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <tuple>
+
+#include "process.h"
+#include "trace.h"
+#include "trace_diff.h"
+
+namespace {
+
+using Kind = graph::TraceDiff::Node::Kind;
+
+//! pair of spans to visit, one of them is nullptr for unmatched spans
+struct Task
+{
+    const graph::Span *left;
+    const graph::Span *right;
+    quint32 parent;
+    quint32 depth;
+};
+
+std::tuple<quint32, quint32> spanKey(const graph::Span *span)
+{
+    const auto service = span->process != nullptr ? span->process->name.id() : 0;
+    return {service, span->operationName.id()};
+}
+
+bool lessByKey(const graph::Span *a, const graph::Span *b)
+{
+    return std::make_tuple(spanKey(a), a->shift) < std::make_tuple(spanKey(b), b->shift);
+}
+
+} // namespace
+
+namespace graph {
+
+std::chrono::microseconds TraceDiff::Node::delta() const noexcept
+{
+    if (kind != Kind::Matched) {
+        return std::chrono::microseconds::zero();
+    }
+
+    return right->duration - left->duration;
+}
+
+TraceDiff TraceDiff::compute(const Trace &left, const Trace &right)
+{
+    TraceDiff diff;
+    std::vector<Task> stack;
+
+    if (left.root != nullptr && right.root != nullptr
+        && spanKey(left.root) == spanKey(right.root)) {
+        stack.push_back({left.root, right.root, NoParent, 0});
+    } else {
+        // pushed in reverse, removed comes first
+        if (right.root != nullptr) {
+            stack.push_back({nullptr, right.root, NoParent, 0});
+        }
+        if (left.root != nullptr) {
+            stack.push_back({left.root, nullptr, NoParent, 0});
+        }
+    }
+
+    std::vector<const Span *> leftChildren;
+    std::vector<const Span *> rightChildren;
+    std::vector<Task> children;
+
+    while (!stack.empty()) {
+        const auto task = stack.back();
+        stack.pop_back();
+
+        Node node;
+        node.left = task.left;
+        node.right = task.right;
+        node.parent = task.parent;
+        node.depth = task.depth;
+
+        if (task.left == nullptr) {
+            node.kind = Kind::Added;
+            diff.addedSpans += task.right->descendantCount + 1;
+        } else if (task.right == nullptr) {
+            node.kind = Kind::Removed;
+            diff.removedSpans += task.left->descendantCount + 1;
+        }
+
+        const auto index = static_cast<quint32>(diff.nodes.size());
+        diff.nodes.push_back(node);
+        if (node.kind != Kind::Matched) {
+            continue;
+        }
+
+        // children grouped by key, the n-th of a group pairs with the n-th of the other side
+        leftChildren.assign(task.left->children.begin(), task.left->children.end());
+        rightChildren.assign(task.right->children.begin(), task.right->children.end());
+        std::sort(leftChildren.begin(), leftChildren.end(), lessByKey);
+        std::sort(rightChildren.begin(), rightChildren.end(), lessByKey);
+
+        children.clear();
+        auto l = leftChildren.cbegin();
+        auto r = rightChildren.cbegin();
+        while (l != leftChildren.cend() || r != rightChildren.cend()) {
+            if (r == rightChildren.cend()
+                || (l != leftChildren.cend() && spanKey(*l) < spanKey(*r))) {
+                children.push_back({*l++, nullptr, index, task.depth + 1});
+            } else if (l == leftChildren.cend() || spanKey(*r) < spanKey(*l)) {
+                children.push_back({nullptr, *r++, index, task.depth + 1});
+            } else {
+                children.push_back({*l++, *r++, index, task.depth + 1});
+            }
+        }
+
+        // visited in order of shift, the stack pops the first child first
+        std::stable_sort(children.begin(), children.end(), [](const Task &a, const Task &b) {
+            const auto *spanA = a.left != nullptr ? a.left : a.right;
+            const auto *spanB = b.left != nullptr ? b.left : b.right;
+            return spanA->shift > spanB->shift;
+        });
+        stack.insert(stack.end(), children.cbegin(), children.cend());
+    }
+
+    return diff;
+}
+
+} // namespace graph
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <vector>
+
+#include "span.h"
+
+namespace graph {
+
+struct Trace;
+
+/*!
+ * Structural difference of two traces.
+ *
+ * Spans match when they have the same service and operation and their
+ * parents match; the n-th such child of one parent is paired with the n-th
+ * one of the other, in order of their shift from the root. Spans without a
+ * pair are reported as the root of an added or removed subtree, their
+ * descendants are not listed again.
+ */
+struct TraceDiff
+{
+    static constexpr quint32 NoParent = std::numeric_limits<quint32>::max();
+
+    struct Node
+    {
+        enum class Kind : quint8 { Matched, Added, Removed };
+
+        //! nullptr for added subtrees
+        const Span *left = nullptr;
+        //! nullptr for removed subtrees
+        const Span *right = nullptr;
+        //! index in nodes
+        quint32 parent = NoParent;
+        quint32 depth = 0;
+        Kind kind = Kind::Matched;
+
+        //! right duration - left duration, zero unless matched
+        std::chrono::microseconds delta() const noexcept;
+    };
+
+    //! preorder of the merged tree
+    std::vector<Node> nodes;
+    //! spans of the added and removed subtrees including their roots
+    quint32 addedSpans = 0;
+    quint32 removedSpans = 0;
+
+    //! O(n log k) for n spans and at most k children per span
+    static TraceDiff compute(const Trace &left, const Trace &right);
+};
+
+} // namespace graph
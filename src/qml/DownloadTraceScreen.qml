@@ -1,6 +1,7 @@
 import QtQuick
 import QtQuick.Layouts
 import QtQuick.Controls
+import QtQuick.Dialogs
 import jaeger
 import "components" as Components
 import "pages.js" as Pages
@@ -18,6 +19,14 @@ Item {
         }
     }
 
+    FileDialog {
+        id: fileDialog
+        nameFilters: [qsTr("Traces (*.json *.jgv)"), qsTr("All files (*)")]
+        onAccepted: {
+            downloader.open(selectedFile);
+        }
+    }
+
     Components.ErrorDialog {
         id: errDialog
         anchors.centerIn: parent
@@ -40,5 +49,10 @@ Item {
                 }
             }
         }
+
+        Button {
+            text: qsTr("Open file")
+            onClicked: fileDialog.open()
+        }
     }
 }
@@ -23,7 +23,7 @@ Item {
     }
 
     FlatLogModel {
-        id: model
+        id: logModel
         graph: item.graph
     }
 
@@ -38,7 +38,7 @@ Item {
 
     FilteredLogModel {
         id: filterModel
-        sourceModel: model
+        sourceModel: logModel
 
         logLevel: logLevelModel
         process: processModel
@@ -147,6 +147,31 @@ Item {
         spacing: 0
         anchors.fill: parent
 
+        RowLayout {
+            Layout.fillWidth: true
+            Layout.margins: 4
+
+            TextField {
+                id: searchField
+                Layout.fillWidth: true
+                placeholderText: "Search logs"
+                selectByMouse: true
+                onTextChanged: searchTimer.restart()
+            }
+
+            Timer {
+                id: searchTimer
+                // one search once typing pauses, not one per keystroke
+                interval: 250
+                onTriggered: filterModel.searchText = searchField.text
+            }
+
+            Label {
+                visible: searchField.text.length >= filterModel.minSearchLength
+                text: filterModel.searching ? (logModel.searchIndexed ? "searching" : "indexing") : filterModel.matchCount + " matches"
+            }
+        }
+
         Rectangle {
             height: 30
             Layout.fillWidth: true
@@ -224,6 +249,17 @@ Item {
                             }
                         }
 
+                        Button {
+                            text: "✕"
+                            implicitHeight: 22
+                            implicitWidth: 22
+                            anchors.right: parent.right
+                            anchors.rightMargin: 4
+                            anchors.verticalCenter: parent.verticalCenter
+                            visible: index === 2 && logModel.subtreeRoot !== ""
+                            onClicked: logModel.clearSubtree()
+                        }
+
                         Rectangle {
                             id: splitter
                             visible: index > 0
@@ -303,7 +339,7 @@ Item {
                     }
 
                     Text {
-                        // span
+                        // span, a click keeps logs of its subtree only
                         text: span
 
                         Layout.fillHeight: true
@@ -312,6 +348,15 @@ Item {
                         elide: Text.ElideRight
                         verticalAlignment: Text.AlignVCenter
                         horizontalAlignment: Text.AlignHCenter
+
+                        MouseArea {
+                            anchors.fill: parent
+                            cursorShape: Qt.PointingHandCursor
+                            onClicked: {
+                                const sourceIndex = filterModel.mapToSource(filterModel.index(row, 0));
+                                logModel.restrictToSubtree(sourceIndex.row);
+                            }
+                        }
                     }
 
                     Text {
@@ -332,11 +377,6 @@ Item {
                         Layout.fillWidth: true
                         clip: true
 
-                        FieldsModel {
-                            id: feilsdModel
-                            fields: message
-                        }
-
                         Row {
                             anchors.verticalCenter: parent.verticalCenter
                             spacing: 2
@@ -348,28 +388,10 @@ Item {
                                 onClicked: tableFieldsPopup.drawFields(message)
                             }
 
-                            Repeater {
-                                model: feilsdModel
-                                Row {
-                                    spacing: 2
-                                    Text {
-                                        text: key
-                                        color: "#7a7777"
-                                    }
-
-                                    Text {
-                                        text: " = "
-                                        color: "#7a7777"
-                                    }
-
-                                    Text {
-                                        text: value
-                                    }
-
-                                    Text {
-                                        text: "; "
-                                    }
-                                }
+                            Text {
+                                // fields on one line, all of them in the popup
+                                text: summary
+                                anchors.verticalCenter: parent.verticalCenter
                             }
                         }
                     }
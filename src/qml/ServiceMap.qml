@@ -15,6 +15,13 @@ Item {
         id: nodeItem
     }
 
+    SpanModel {
+        id: latencyModel
+        aggregated: true
+        graph: item.graph
+        service: nodeItem.processName
+    }
+
     SplitView {
         anchors.fill: parent
         orientation: Qt.Horizontal
@@ -35,13 +42,15 @@ Item {
 
                 //anchors.fill: parent
                 graph: item.graph
+                merged: mergeSwitch.checked
+                groupByTags: tagsSwitch.checked
                 delegate: Rectangle {
                     implicitHeight: content.height + 10
                     implicitWidth: content.width + 10
 
                     visible: true
-                    border.color: "black"
-                    border.width: 1
+                    border.color: node.onCriticalPath ? "#DF0101" : "black"
+                    border.width: node.onCriticalPath ? 2 : 1
 
                     ColumnLayout {
                         id: content
@@ -54,6 +63,11 @@ Item {
                             font.bold: true
                         }
 
+                        Text {
+                            text: node.spanCount + " spans"
+                            color: "#7a7777"
+                        }
+
                         Rectangle {
                             visible: node.hasEdges
                             height: 1
@@ -93,6 +107,22 @@ Item {
 
                 anchors.fill: parent
 
+                RowLayout {
+                    Layout.leftMargin: 8
+
+                    Switch {
+                        id: mergeSwitch
+                        text: "merge traces"
+                        checked: true
+                    }
+
+                    Switch {
+                        id: tagsSwitch
+                        text: "by tags"
+                        enabled: mergeSwitch.checked
+                    }
+                }
+
                 Text {
                     text: nodeItem.processName
                     font.bold: true
@@ -147,9 +177,25 @@ Item {
                     }
                 }
 
-                Text {
+                RowLayout {
                     Layout.leftMargin: 8
-                    text: "Spans"
+
+                    Text {
+                        text: aggregateSwitch.checked ? "Latency of all traces" : "Spans"
+                        Layout.fillWidth: true
+                    }
+
+                    Switch {
+                        id: aggregateSwitch
+                        text: "aggregate"
+                    }
+
+                    Switch {
+                        text: "collapse"
+                        checked: true
+                        visible: !aggregateSwitch.checked
+                        onToggled: nodeItem.spanModel.collapsed = checked
+                    }
                 }
 
                 Rectangle {
@@ -166,6 +212,7 @@ Item {
                     height: 300
                     clip: true
 
+                    visible: !aggregateSwitch.checked
                     Layout.fillHeight: true
                     Layout.fillWidth: true
                     model: nodeItem.spanModel
@@ -196,13 +243,48 @@ Item {
                                 }
 
                                 Text {
-                                    text: "duration:"
+                                    text: count > 1 ? "avg:" : "duration:"
                                     color: "#7a7777"
                                 }
 
                                 Text {
                                     text: duration
                                 }
+
+                                Text {
+                                    visible: onCriticalPath
+                                    text: "|"
+                                    color: "#7a7777"
+                                }
+
+                                Text {
+                                    visible: onCriticalPath
+                                    text: "critical:"
+                                    color: "#7a7777"
+                                }
+
+                                Text {
+                                    visible: onCriticalPath
+                                    text: criticalTime
+                                    color: "#DF0101"
+                                }
+
+                                Text {
+                                    visible: count > 1
+                                    text: "|"
+                                    color: "#7a7777"
+                                }
+
+                                Text {
+                                    visible: count > 1
+                                    text: "×" + count + " min/max:"
+                                    color: "#7a7777"
+                                }
+
+                                Text {
+                                    visible: count > 1
+                                    text: minDuration + " / " + maxDuration
+                                }
                             }
 
                             Text {
@@ -214,6 +296,59 @@ Item {
                         policy: ScrollBar.AsNeeded
                     }
                 }
+
+                ListView {
+                    id: latencyView
+                    width: 200
+                    height: 300
+                    clip: true
+
+                    visible: aggregateSwitch.checked
+                    Layout.fillHeight: true
+                    Layout.fillWidth: true
+                    model: latencyModel
+
+                    delegate: Rectangle {
+                        width: latencyView.width
+                        height: 48
+                        color: index % 2 === 0 ? "#ffffff" : "#efefef"
+
+                        ColumnLayout {
+                            anchors.fill: parent
+                            anchors.margins: 2
+
+                            Text {
+                                text: operationName
+                            }
+
+                            Row {
+                                spacing: 4
+
+                                Repeater {
+                                    model: [["count:", count], ["p50:", p50], ["p95:", p95],
+                                        ["p99:", p99]]
+
+                                    Row {
+                                        spacing: 4
+
+                                        Text {
+                                            text: modelData[0]
+                                            color: "#7a7777"
+                                        }
+
+                                        Text {
+                                            text: modelData[1]
+                                            font: Style.MonoFontFamily
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                    ScrollBar.vertical: ScrollBar {
+                        policy: ScrollBar.AsNeeded
+                    }
+                }
             }
         }
     }
@@ -0,0 +1,108 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+import jaeger
+import "style.js" as Style
+
+Page {
+    id: page
+    property var trace
+
+    TraceDiffModel {
+        id: diffModel
+        graph: page.trace
+    }
+
+    header: ToolBar {
+        RowLayout {
+            ToolButton {
+                text: qsTr("Back")
+                onClicked: stackView.pop()
+            }
+
+            Label {
+                text: qsTr("Left trace")
+            }
+
+            SpinBox {
+                from: 0
+                to: Math.max(diffModel.traceCount - 1, 0)
+                value: diffModel.leftTrace
+                onValueModified: diffModel.leftTrace = value
+            }
+
+            Label {
+                text: qsTr("Right trace")
+            }
+
+            SpinBox {
+                from: 0
+                to: Math.max(diffModel.traceCount - 1, 0)
+                value: diffModel.rightTrace
+                onValueModified: diffModel.rightTrace = value
+            }
+
+            Label {
+                text: qsTr("+%1 / -%2 spans").arg(diffModel.addedSpans).arg(diffModel.removedSpans)
+            }
+        }
+    }
+
+    ListView {
+        id: diffView
+        anchors.fill: parent
+        clip: true
+        model: diffModel
+
+        delegate: Rectangle {
+            width: diffView.width
+            height: 28
+            color: kind === "added" ? "#d7f5dd" : kind === "removed" ? "#f8d7da"
+                                                                     : index % 2 === 0 ? "#ffffff"
+                                                                                       : "#efefef"
+
+            RowLayout {
+                anchors.fill: parent
+                anchors.leftMargin: 8 + depth * 16
+                anchors.rightMargin: 8
+                spacing: 8
+
+                Text {
+                    text: service
+                    font.bold: true
+                }
+
+                Text {
+                    text: operationName
+                    Layout.fillWidth: true
+                    elide: Text.ElideRight
+                }
+
+                Text {
+                    visible: kind !== "matched"
+                    text: qsTr("%1 spans").arg(subtreeSize)
+                }
+
+                Text {
+                    text: leftDuration
+                    font: Style.MonoFontFamily
+                }
+
+                Text {
+                    text: rightDuration
+                    font: Style.MonoFontFamily
+                }
+
+                Text {
+                    text: delta
+                    color: slower ? "#DF0101" : "#088A08"
+                    font: Style.MonoFontFamily
+                }
+            }
+        }
+
+        ScrollBar.vertical: ScrollBar {
+            policy: ScrollBar.AsNeeded
+        }
+    }
+}
@@ -1,11 +1,50 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
+import QtQuick.Dialogs
+import jaeger
+import "components" as Components
+import "pages.js" as Pages
 
 Page {
     id: page
     property var trace
 
+    header: ToolBar {
+        RowLayout {
+            ToolButton {
+                text: qsTr("Save snapshot")
+                onClicked: snapshotDialog.open()
+            }
+            ToolButton {
+                text: qsTr("Compare traces")
+                onClicked: Pages.createTraceDiffScreen(page.trace)
+            }
+        }
+    }
+
+    SnapshotWriter {
+        id: snapshotWriter
+        onErrorSnapshot: errMessage => {
+            errDialog.show(errMessage);
+        }
+    }
+
+    FileDialog {
+        id: snapshotDialog
+        fileMode: FileDialog.SaveFile
+        defaultSuffix: "jgv"
+        nameFilters: [qsTr("JGV snapshot (*.jgv)")]
+        onAccepted: {
+            snapshotWriter.saveSnapshot(page.trace, selectedFile);
+        }
+    }
+
+    Components.ErrorDialog {
+        id: errDialog
+        anchors.centerIn: parent
+    }
+
     SplitView {
         anchors.fill: parent
         orientation: Qt.Vertical
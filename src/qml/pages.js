@@ -4,3 +4,10 @@ function createTraceScreen(trace) {
     let traceScreen = component.createObject(appWindow);
     stackView.push(traceScreen, {"trace": trace});
 }
+
+function createTraceDiffScreen(trace) {
+    let component = Qt.createComponent("qrc:/qml/TraceDiffScreen.qml");
+
+    let traceDiffScreen = component.createObject(appWindow);
+    stackView.push(traceDiffScreen, {"trace": trace});
+}
@@ -0,0 +1,91 @@
+#include "id.h"
+
+namespace {
+
+int hexDigit(char c) noexcept
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool parseHex(std::string_view hex, quint64 *value) noexcept
+{
+    quint64 v = 0;
+    for (auto c : hex) {
+        const auto digit = hexDigit(c);
+        if (digit < 0) {
+            return false;
+        }
+        v = (v << 4) | static_cast<quint64>(digit);
+    }
+
+    *value = v;
+    return true;
+}
+
+void appendHex(QString &out, quint64 value)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        out += QLatin1Char(digits[(value >> shift) & 0xF]);
+    }
+}
+
+} // namespace
+
+namespace trace {
+
+SpanID SpanID::fromHex(std::string_view hex) noexcept
+{
+    quint64 value = 0;
+    if (hex.size() > 16 || !parseHex(hex, &value)) {
+        return {};
+    }
+
+    return SpanID(value);
+}
+
+QString SpanID::toString() const
+{
+    QString out;
+    out.reserve(16);
+    appendHex(out, m_value);
+    return out;
+}
+
+TraceID TraceID::fromHex(std::string_view hex) noexcept
+{
+    if (hex.size() > 32) {
+        return {};
+    }
+
+    const auto split = hex.size() > 16 ? hex.size() - 16 : 0;
+    quint64 high = 0;
+    quint64 low = 0;
+    if (!parseHex(hex.substr(0, split), &high) || !parseHex(hex.substr(split), &low)) {
+        return {};
+    }
+
+    return TraceID(high, low, hex.size() > 16);
+}
+
+QString TraceID::toString() const
+{
+    QString out;
+    out.reserve(m_wide ? 32 : 16);
+    if (m_wide) {
+        appendHex(out, m_high);
+    }
+    appendHex(out, m_low);
+    return out;
+}
+
+} // namespace trace
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string_view>
+
+#include <QtCore/QHashFunctions>
+#include <QtCore/QMetaType>
+#include <QtCore/QString>
+
+namespace trace {
+
+//! 64-bit span id decoded from hex, zero is not a valid id
+class SpanID
+{
+public:
+    constexpr SpanID() = default;
+    explicit constexpr SpanID(quint64 value) noexcept
+        : m_value(value)
+    {}
+
+    //! up to 16 hex digits, empty id on malformed input
+    static SpanID fromHex(std::string_view hex) noexcept;
+
+    constexpr quint64 value() const noexcept { return m_value; }
+    constexpr bool isEmpty() const noexcept { return m_value == 0; }
+
+    //! 16 lower case hex digits
+    QString toString() const;
+
+    friend constexpr bool operator==(SpanID a, SpanID b) noexcept { return a.m_value == b.m_value; }
+    friend constexpr bool operator!=(SpanID a, SpanID b) noexcept { return a.m_value != b.m_value; }
+    friend constexpr bool operator<(SpanID a, SpanID b) noexcept { return a.m_value < b.m_value; }
+
+private:
+    quint64 m_value = 0;
+};
+
+//! 128-bit trace id decoded from hex, zero is not a valid id
+class TraceID
+{
+public:
+    constexpr TraceID() = default;
+    constexpr TraceID(quint64 high, quint64 low, bool wide = false) noexcept
+        : m_high(high)
+        , m_low(low)
+        , m_wide(wide || high != 0)
+    {}
+
+    //! up to 32 hex digits, empty id on malformed input. More than 16 digits make a wide id
+    static TraceID fromHex(std::string_view hex) noexcept;
+
+    constexpr quint64 high() const noexcept { return m_high; }
+    constexpr quint64 low() const noexcept { return m_low; }
+    constexpr bool isEmpty() const noexcept { return m_high == 0 && m_low == 0; }
+    //! written with 32 digits, even when the high half is zero
+    constexpr bool isWide() const noexcept { return m_wide; }
+
+    //! 16 hex digits for 64-bit ids, 32 for wide ones, as the id was written by Jaeger
+    QString toString() const;
+
+    friend constexpr bool operator==(TraceID a, TraceID b) noexcept
+    {
+        return a.m_high == b.m_high && a.m_low == b.m_low;
+    }
+    friend constexpr bool operator!=(TraceID a, TraceID b) noexcept { return !(a == b); }
+    friend constexpr bool operator<(TraceID a, TraceID b) noexcept
+    {
+        return a.m_high != b.m_high ? a.m_high < b.m_high : a.m_low < b.m_low;
+    }
+
+private:
+    quint64 m_high = 0;
+    quint64 m_low = 0;
+    //! not part of the value, ids of both widths with equal halves are equal
+    bool m_wide = false;
+};
+
+inline size_t qHash(SpanID id, size_t seed = 0) noexcept
+{
+    return ::qHash(id.value(), seed);
+}
+
+inline size_t qHash(TraceID id, size_t seed = 0) noexcept
+{
+    return qHashMulti(seed, id.high(), id.low());
+}
+
+} // namespace trace
+
+Q_DECLARE_METATYPE(trace::SpanID)
+Q_DECLARE_METATYPE(trace::TraceID)
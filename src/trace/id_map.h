@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+#include "id.h"
+
+namespace trace {
+
+/*!
+ * Open addressing map from SpanID to a value, sized once for a trace.
+ *
+ * Span ids are random 64-bit numbers, so a multiplicative hash and linear
+ * probing over a power of two table are enough and avoid per-node
+ * allocations of QHash.
+ */
+template<typename T>
+class SpanIDMap
+{
+public:
+    explicit SpanIDMap(size_t count)
+    {
+        size_t capacity = 16;
+        while (capacity < count * 2) {
+            capacity <<= 1;
+        }
+
+        m_mask = capacity - 1;
+        m_slots.resize(capacity);
+    }
+
+    //! replaces the value of an id inserted before
+    void insert(SpanID id, T value)
+    {
+        if (id.isEmpty()) {
+            return;
+        }
+
+        for (auto i = slot(id);; i = (i + 1) & m_mask) {
+            auto &s = m_slots[i];
+            if (s.id.isEmpty() || s.id == id) {
+                s.id = id;
+                s.value = value;
+                return;
+            }
+        }
+    }
+
+    T value(SpanID id, T defaultValue = T()) const
+    {
+        if (id.isEmpty()) {
+            return defaultValue;
+        }
+
+        for (auto i = slot(id);; i = (i + 1) & m_mask) {
+            const auto &s = m_slots[i];
+            if (s.id == id) {
+                return s.value;
+            }
+            if (s.id.isEmpty()) {
+                return defaultValue;
+            }
+        }
+    }
+
+private:
+    size_t slot(SpanID id) const noexcept
+    {
+        return static_cast<size_t>((id.value() * 0x9E3779B97F4A7C15ULL) >> 32) & m_mask;
+    }
+
+private:
+    struct Slot
+    {
+        SpanID id;
+        T value{};
+    };
+
+    std::vector<Slot> m_slots;
+    size_t m_mask = 0;
+};
+
+} // namespace trace
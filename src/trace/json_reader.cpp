@@ -0,0 +1,775 @@
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+#include "json_reader.h"
+
+namespace {
+
+bool isValueToken(trace::JsonReader::Token token)
+{
+    switch (token) {
+    case trace::JsonReader::Token::BeginObject:
+    case trace::JsonReader::Token::BeginArray:
+    case trace::JsonReader::Token::String:
+    case trace::JsonReader::Token::Number:
+    case trace::JsonReader::Token::Bool:
+    case trace::JsonReader::Token::Null:
+        return true;
+    default:
+        return false;
+    }
+}
+
+constexpr uint64_t NoPosition = ~uint64_t(0);
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+//! character that may follow a number or a literal
+bool isDelimiter(char c)
+{
+    switch (c) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case ',':
+    case ']':
+    case '}':
+    case ':':
+        return true;
+    default:
+        return false;
+    }
+}
+
+int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+void appendUtf8(std::string &out, uint32_t cp)
+{
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+} // namespace
+
+namespace trace {
+
+JsonReader::JsonReader(std::string_view data)
+    : m_begin(data.data())
+    , m_pos(data.data())
+    , m_end(data.data() + data.size())
+{
+    m_stack.reserve(16);
+}
+
+JsonReader::JsonReader(std::string_view data, StructuralScanner::Implementation implementation)
+    : JsonReader(data)
+{
+    m_scanner = std::make_unique<StructuralScanner>(data, implementation);
+    m_positions.reserve(StructuralScanner::WindowSize / 4);
+}
+
+JsonReader::Token JsonReader::peek()
+{
+    if (hasError()) {
+        return Token::Error;
+    }
+
+    skipWhitespace();
+    if (m_pos == m_end) {
+        return Token::End;
+    }
+
+    switch (*m_pos) {
+    case '{':
+        return Token::BeginObject;
+    case '}':
+        return Token::EndObject;
+    case '[':
+        return Token::BeginArray;
+    case ']':
+        return Token::EndArray;
+    case '"':
+        return Token::String;
+    case 't':
+    case 'f':
+        return Token::Bool;
+    case 'n':
+        return Token::Null;
+    default:
+        break;
+    }
+
+    if (*m_pos == '-' || isDigit(*m_pos)) {
+        return Token::Number;
+    }
+
+    setError("unexpected character");
+    return Token::Error;
+}
+
+bool JsonReader::beginObject()
+{
+    const auto token = peek();
+    if (token != Token::BeginObject) {
+        return mismatch(token);
+    }
+
+    ++m_pos;
+    m_stack.push_back(Frame{false, true});
+    return true;
+}
+
+bool JsonReader::nextKey(std::string_view *key)
+{
+    if (!nextItem(false)) {
+        return false;
+    }
+
+    if (*m_pos != '"') {
+        return setError("expected object key");
+    }
+
+    std::string_view k;
+    if (!parseString(&k)) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (m_pos == m_end || *m_pos != ':') {
+        return setError("expected ':'");
+    }
+    ++m_pos;
+
+    *key = k;
+    return true;
+}
+
+bool JsonReader::beginArray()
+{
+    const auto token = peek();
+    if (token != Token::BeginArray) {
+        return mismatch(token);
+    }
+
+    ++m_pos;
+    m_stack.push_back(Frame{true, true});
+    return true;
+}
+
+bool JsonReader::nextElement()
+{
+    return nextItem(true);
+}
+
+bool JsonReader::readString(std::string_view *value)
+{
+    const auto token = peek();
+    if (token == Token::String) {
+        return parseString(value);
+    }
+
+    return mismatch(token);
+}
+
+bool JsonReader::readInt64(int64_t *value)
+{
+    std::string_view text;
+    if (!readNumber(&text)) {
+        return false;
+    }
+
+    return toInt64(text, value);
+}
+
+bool JsonReader::readDouble(double *value)
+{
+    std::string_view text;
+    if (!readNumber(&text)) {
+        return false;
+    }
+
+    return toDouble(text, value);
+}
+
+bool JsonReader::readNumber(std::string_view *text)
+{
+    const auto token = peek();
+    if (token != Token::Number) {
+        return mismatch(token);
+    }
+
+    return parseNumber(text);
+}
+
+bool JsonReader::toInt64(std::string_view text, int64_t *value) noexcept
+{
+    const auto last = text.data() + text.size();
+    auto res = std::from_chars(text.data(), last, *value);
+    if (res.ec == std::errc() && res.ptr == last) {
+        return true;
+    }
+
+    // 1.0e3 is still an integer value
+    double d = 0;
+    if (!toDouble(text, &d) || std::trunc(d) != d
+        || std::fabs(d) >= static_cast<double>(std::numeric_limits<int64_t>::max())) {
+        *value = 0;
+        return false;
+    }
+
+    *value = static_cast<int64_t>(d);
+    return true;
+}
+
+bool JsonReader::toDouble(std::string_view text, double *value) noexcept
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto res = std::from_chars(text.data(), text.data() + text.size(), *value);
+    return res.ec == std::errc() && res.ptr == text.data() + text.size();
+#else
+    // strtod depends on the process locale, QGuiApplication sets it from the environment
+    try {
+        std::istringstream stream{std::string(text)};
+        stream.imbue(std::locale::classic());
+        stream >> *value;
+        return !stream.fail();
+    } catch (...) {
+        return false;
+    }
+#endif
+}
+
+bool JsonReader::readBool(bool *value)
+{
+    const auto token = peek();
+    if (token != Token::Bool) {
+        return mismatch(token);
+    }
+
+    if (*m_pos == 't') {
+        *value = true;
+        return parseLiteral("true");
+    }
+
+    *value = false;
+    return parseLiteral("false");
+}
+
+bool JsonReader::skipValue()
+{
+    std::string_view tmp;
+    switch (peek()) {
+    case Token::BeginObject:
+    case Token::BeginArray:
+        return skipContainer();
+    case Token::String:
+        return parseString(&tmp);
+    case Token::Number:
+        return parseNumber(&tmp);
+    case Token::Bool:
+        return parseLiteral(*m_pos == 't' ? "true" : "false");
+    case Token::Null:
+        return parseLiteral("null");
+    case Token::Error:
+        return false;
+    default:
+        return setError("expected value");
+    }
+}
+
+bool JsonReader::skipValue(std::string_view *raw)
+{
+    if (peek() == Token::Error) {
+        return false;
+    }
+
+    const auto begin = m_pos;
+    if (!skipValue()) {
+        return false;
+    }
+
+    *raw = std::string_view(begin, static_cast<size_t>(m_pos - begin));
+    return true;
+}
+
+bool JsonReader::atEnd()
+{
+    if (hasError()) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (m_pos != m_end) {
+        return setError("unexpected data after value");
+    }
+
+    return true;
+}
+
+bool JsonReader::hasError() const noexcept
+{
+    return !m_error.empty();
+}
+
+const std::string &JsonReader::errorString() const noexcept
+{
+    return m_error;
+}
+
+size_t JsonReader::offset() const noexcept
+{
+    return static_cast<size_t>(m_pos - m_begin);
+}
+
+bool JsonReader::isInput(std::string_view value) const noexcept
+{
+    return std::less_equal<const char *>()(m_begin, value.data())
+           && std::less_equal<const char *>()(value.data() + value.size(), m_end);
+}
+
+void JsonReader::skipWhitespace()
+{
+    if (m_scanner) {
+        // everything between indexed tokens is whitespace
+        const auto next = nextIndexed(static_cast<uint64_t>(m_pos - m_begin));
+        if (next != NoPosition) {
+            m_pos = m_begin + next;
+        } else if (!hasError()) {
+            m_pos = m_end;
+        }
+        return;
+    }
+
+    while (m_pos != m_end
+           && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+        ++m_pos;
+    }
+}
+
+uint64_t JsonReader::nextIndexed(uint64_t offset)
+{
+    for (;;) {
+        while (m_cursor < m_positions.size() && m_positions[m_cursor] < offset) {
+            ++m_cursor;
+        }
+
+        if (m_cursor < m_positions.size()) {
+            return m_positions[m_cursor];
+        }
+
+        m_cursor = 0;
+        if (!m_scanner->scan(m_positions)) {
+            return NoPosition;
+        }
+
+        if (m_scanner->hasError()) {
+            m_pos = m_begin + m_scanner->errorOffset();
+            setError("control character in string");
+            return NoPosition;
+        }
+    }
+}
+
+bool JsonReader::nextItem(bool array)
+{
+    if (hasError()) {
+        return false;
+    }
+
+    if (m_stack.empty() || m_stack.back().array != array) {
+        return setError(array ? "not inside array" : "not inside object");
+    }
+
+    skipWhitespace();
+    if (m_pos == m_end) {
+        return setError("unexpected end of data");
+    }
+
+    auto &frame = m_stack.back();
+    if (*m_pos == (array ? ']' : '}')) {
+        ++m_pos;
+        m_stack.pop_back();
+        return false;
+    }
+
+    if (!frame.empty) {
+        if (*m_pos != ',') {
+            return setError(array ? "expected ',' or ']'" : "expected ',' or '}'");
+        }
+        ++m_pos;
+        skipWhitespace();
+        if (m_pos == m_end) {
+            return setError("unexpected end of data");
+        }
+    }
+
+    frame.empty = false;
+    return true;
+}
+
+bool JsonReader::parseString(std::string_view *value)
+{
+    const char *start = ++m_pos;
+    const char *p = start;
+
+    if (m_scanner) {
+        // closing quote is the next indexed token, control characters are checked by the scanner
+        const auto close = nextIndexed(static_cast<uint64_t>(start - m_begin));
+        if (close == NoPosition) {
+            m_pos = hasError() ? m_pos : m_end;
+            return setError("unterminated string");
+        }
+
+        const char *end = m_begin + close;
+        p = static_cast<const char *>(std::memchr(start, '\\', static_cast<size_t>(end - start)));
+        if (p == nullptr) {
+            *value = std::string_view(start, static_cast<size_t>(end - start));
+            m_pos = end + 1;
+            return true;
+        }
+    } else {
+        for (; p != m_end; ++p) {
+            const auto c = static_cast<unsigned char>(*p);
+            if (c == '"') {
+                *value = std::string_view(start, static_cast<size_t>(p - start));
+                m_pos = p + 1;
+                return true;
+            }
+            if (c == '\\') {
+                break;
+            }
+            if (c < 0x20) {
+                m_pos = p;
+                return setError("control character in string");
+            }
+        }
+    }
+
+    m_scratch.assign(start, p);
+    while (p != m_end) {
+        const auto c = static_cast<unsigned char>(*p);
+        if (c == '"') {
+            *value = m_scratch;
+            m_pos = p + 1;
+            return true;
+        }
+
+        if (c < 0x20) {
+            m_pos = p;
+            return setError("control character in string");
+        }
+
+        if (c != '\\') {
+            m_scratch.push_back(*p++);
+            continue;
+        }
+
+        if (++p == m_end) {
+            break;
+        }
+
+        switch (*p++) {
+        case '"':
+            m_scratch.push_back('"');
+            break;
+        case '\\':
+            m_scratch.push_back('\\');
+            break;
+        case '/':
+            m_scratch.push_back('/');
+            break;
+        case 'b':
+            m_scratch.push_back('\b');
+            break;
+        case 'f':
+            m_scratch.push_back('\f');
+            break;
+        case 'n':
+            m_scratch.push_back('\n');
+            break;
+        case 'r':
+            m_scratch.push_back('\r');
+            break;
+        case 't':
+            m_scratch.push_back('\t');
+            break;
+        case 'u': {
+            auto readCodeUnit = [this, &p](uint32_t *unit) {
+                if (m_end - p < 4) {
+                    return false;
+                }
+                uint32_t u = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const int digit = hexDigit(p[i]);
+                    if (digit < 0) {
+                        return false;
+                    }
+                    u = (u << 4) | static_cast<uint32_t>(digit);
+                }
+                p += 4;
+                *unit = u;
+                return true;
+            };
+
+            uint32_t cp = 0;
+            if (!readCodeUnit(&cp)) {
+                m_pos = p;
+                return setError("invalid unicode escape");
+            }
+
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                uint32_t low = 0;
+                if (m_end - p < 2 || p[0] != '\\' || p[1] != 'u') {
+                    cp = 0xFFFD;
+                } else if (p += 2; !readCodeUnit(&low)) {
+                    m_pos = p;
+                    return setError("invalid unicode escape");
+                } else if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else {
+                    // lone high surrogate followed by another escape
+                    appendUtf8(m_scratch, 0xFFFD);
+                    cp = (low >= 0xD800 && low <= 0xDFFF) ? 0xFFFD : low;
+                }
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                cp = 0xFFFD;
+            }
+            appendUtf8(m_scratch, cp);
+        } break;
+        default:
+            m_pos = p - 1;
+            return setError("invalid escape sequence");
+        }
+    }
+
+    m_pos = m_end;
+    return setError("unterminated string");
+}
+
+bool JsonReader::parseNumber(std::string_view *value)
+{
+    const char *start = m_pos;
+    const char *p = m_pos;
+
+    if (p != m_end && *p == '-') {
+        ++p;
+    }
+
+    if (p == m_end || !isDigit(*p)) {
+        m_pos = p;
+        return setError("invalid number");
+    }
+
+    if (*p == '0') {
+        ++p;
+    } else {
+        while (p != m_end && isDigit(*p)) {
+            ++p;
+        }
+    }
+
+    if (p != m_end && *p == '.') {
+        ++p;
+        if (p == m_end || !isDigit(*p)) {
+            m_pos = p;
+            return setError("invalid number");
+        }
+        while (p != m_end && isDigit(*p)) {
+            ++p;
+        }
+    }
+
+    if (p != m_end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p != m_end && (*p == '+' || *p == '-')) {
+            ++p;
+        }
+        if (p == m_end || !isDigit(*p)) {
+            m_pos = p;
+            return setError("invalid number");
+        }
+        while (p != m_end && isDigit(*p)) {
+            ++p;
+        }
+    }
+
+    if (p != m_end && !isDelimiter(*p)) {
+        m_pos = p;
+        return setError("invalid number");
+    }
+
+    *value = std::string_view(start, static_cast<size_t>(p - start));
+    m_pos = p;
+    return true;
+}
+
+bool JsonReader::parseLiteral(std::string_view literal)
+{
+    if (static_cast<size_t>(m_end - m_pos) < literal.size()
+        || std::memcmp(m_pos, literal.data(), literal.size()) != 0) {
+        return setError("invalid literal");
+    }
+
+    m_pos += literal.size();
+    if (m_pos != m_end && !isDelimiter(*m_pos)) {
+        return setError("invalid literal");
+    }
+
+    return true;
+}
+
+bool JsonReader::skipContainer()
+{
+    if (m_scanner) {
+        return skipIndexedContainer();
+    }
+
+    // brackets must pair up, scalars of skipped values are not validated
+    std::string closers;
+    const char *p = m_pos;
+
+    while (p != m_end) {
+        switch (*p) {
+        case '"':
+            for (++p; p != m_end && *p != '"'; ++p) {
+                if (*p == '\\' && ++p == m_end) {
+                    break;
+                }
+            }
+            if (p == m_end) {
+                m_pos = p;
+                return setError("unterminated string");
+            }
+            break;
+        case '{':
+        case '[':
+            closers.push_back(*p == '{' ? '}' : ']');
+            break;
+        case '}':
+        case ']':
+            if (closers.empty() || closers.back() != *p) {
+                m_pos = p;
+                return setError("mismatched bracket");
+            }
+            closers.pop_back();
+            if (closers.empty()) {
+                m_pos = p + 1;
+                return true;
+            }
+            break;
+        default:
+            break;
+        }
+        ++p;
+    }
+
+    m_pos = m_end;
+    return setError("unexpected end of data");
+}
+
+bool JsonReader::skipIndexedContainer()
+{
+    std::string closers;
+    auto offset = static_cast<uint64_t>(m_pos - m_begin);
+
+    for (;;) {
+        auto pos = nextIndexed(offset);
+        if (pos == NoPosition) {
+            break;
+        }
+
+        switch (m_begin[pos]) {
+        case '"':
+            // skip the string up to its closing quote
+            pos = nextIndexed(pos + 1);
+            if (pos == NoPosition) {
+                if (!hasError()) {
+                    m_pos = m_end;
+                }
+                return setError("unterminated string");
+            }
+            break;
+        case '{':
+        case '[':
+            closers.push_back(m_begin[pos] == '{' ? '}' : ']');
+            break;
+        case '}':
+        case ']':
+            if (closers.empty() || closers.back() != m_begin[pos]) {
+                m_pos = m_begin + pos;
+                return setError("mismatched bracket");
+            }
+            closers.pop_back();
+            if (closers.empty()) {
+                m_pos = m_begin + pos + 1;
+                return true;
+            }
+            break;
+        default:
+            break;
+        }
+
+        offset = pos + 1;
+    }
+
+    if (!hasError()) {
+        m_pos = m_end;
+    }
+    return setError("unexpected end of data");
+}
+
+bool JsonReader::mismatch(Token token)
+{
+    if (isValueToken(token)) {
+        skipValue();
+    } else if (token != Token::Error) {
+        setError("expected value");
+    }
+
+    return false;
+}
+
+bool JsonReader::setError(const char *message)
+{
+    if (m_error.empty()) {
+        m_error = message;
+    }
+
+    return false;
+}
+
+} // namespace trace
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "structural_scanner.h"
+
+namespace trace {
+
+/*!
+ * Pull JSON reader over a contiguous buffer.
+ *
+ * The reader does not build a document: callers walk objects and arrays
+ * with beginObject()/nextKey() and beginArray()/nextElement() and read
+ * scalars in place. Strings without escapes are returned as views into the
+ * input buffer, escaped strings are decoded into an internal buffer that is
+ * valid until the next string is read.
+ *
+ * Reading a value of an unexpected type skips it and returns false, syntax
+ * errors put the reader into the error state and every later call fails.
+ *
+ * With a StructuralScanner the reader jumps between indexed tokens: strings
+ * end at the next indexed quote and skipped containers are walked over the
+ * index only.
+ */
+class JsonReader
+{
+public:
+    enum class Token {
+        Error,
+        End,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        String,
+        Number,
+        Bool,
+        Null,
+    };
+
+    explicit JsonReader(std::string_view data);
+    JsonReader(std::string_view data, StructuralScanner::Implementation implementation);
+
+    Token peek();
+
+    bool beginObject();
+    bool nextKey(std::string_view *key);
+
+    bool beginArray();
+    bool nextElement();
+
+    bool readString(std::string_view *value);
+    bool readInt64(int64_t *value);
+    bool readDouble(double *value);
+    //! raw text of a number, it always points into the input
+    bool readNumber(std::string_view *text);
+    bool readBool(bool *value);
+    bool skipValue();
+    //! skip a value, raw is its text and always points into the input
+    bool skipValue(std::string_view *raw);
+
+    //! check that only whitespace follows the top level value
+    bool atEnd();
+
+    bool hasError() const noexcept;
+    const std::string &errorString() const noexcept;
+    size_t offset() const noexcept;
+
+    //! value points into the input rather than into decoded scratch memory
+    bool isInput(std::string_view value) const noexcept;
+
+    //! convert text returned by readNumber
+    static bool toInt64(std::string_view text, int64_t *value) noexcept;
+    static bool toDouble(std::string_view text, double *value) noexcept;
+
+private:
+    struct Frame
+    {
+        bool array;
+        bool empty;
+    };
+
+    void skipWhitespace();
+    uint64_t nextIndexed(uint64_t offset);
+    bool nextItem(bool array);
+    bool parseString(std::string_view *value);
+    bool parseNumber(std::string_view *value);
+    bool parseLiteral(std::string_view literal);
+    bool skipContainer();
+    bool skipIndexedContainer();
+    bool mismatch(Token token);
+    bool setError(const char *message);
+
+private:
+    const char *m_begin;
+    const char *m_pos;
+    const char *m_end;
+    std::vector<Frame> m_stack;
+
+    std::unique_ptr<StructuralScanner> m_scanner;
+    std::vector<uint64_t> m_positions;
+    size_t m_cursor = 0;
+
+    std::string m_scratch;
+    std::string m_error;
+};
+
+} // namespace trace
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+#include <QtCore/QThreadPool>
+
+namespace trace {
+
+//! call func(i) for every i in [0, count) on threadCount workers
+template<typename Func>
+void parallelFor(qsizetype count, int threadCount, Func &&func)
+{
+    if (threadCount <= 1 || count <= 1) {
+        for (qsizetype i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(static_cast<int>(std::min<qsizetype>(threadCount, count)));
+
+    // workers pull indexes one by one, traces of a search result differ in size a lot
+    std::atomic<qsizetype> next{0};
+    for (int worker = 0; worker < pool.maxThreadCount(); ++worker) {
+        pool.start([&next, &func, count]() {
+            for (auto i = next++; i < count; i = next++) {
+                func(i);
+            }
+        });
+    }
+
+    pool.waitForDone();
+}
+
+} // namespace trace
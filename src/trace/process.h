@@ -6,7 +6,7 @@ namespace trace {
 
 struct Process
 {
-    QString name;
+    Symbol name;
     Tags tags;
 };
 
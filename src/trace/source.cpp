@@ -0,0 +1,88 @@
+#include <cstring>
+
+#include "source.h"
+
+namespace {
+
+constexpr qsizetype ChunkSize = 64 * 1024;
+
+} // namespace
+
+namespace trace {
+
+Source::~Source()
+{
+    if (m_file) {
+        m_file->unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_view.data())));
+    }
+}
+
+QByteArrayView Source::keep(QByteArrayView bytes) const
+{
+    if (bytes.isEmpty()) {
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    char *dst = nullptr;
+    if (bytes.size() > ChunkSize / 4) {
+        dst = m_large.emplace_back(std::make_unique<char[]>(static_cast<size_t>(bytes.size())))
+                  .get();
+    } else {
+        if (m_chunks.empty() || m_chunkUsed + bytes.size() > ChunkSize) {
+            m_chunks.push_back(std::make_unique<char[]>(ChunkSize));
+            m_chunkUsed = 0;
+        }
+
+        dst = m_chunks.back().get() + m_chunkUsed;
+        m_chunkUsed += bytes.size();
+    }
+
+    std::memcpy(dst, bytes.data(), static_cast<size_t>(bytes.size()));
+    return QByteArrayView(dst, bytes.size());
+}
+
+SourcePtr Source::fromData(const QByteArray &data)
+{
+    std::shared_ptr<Source> source(new Source);
+    source->m_data = data;
+    source->m_view = source->m_data;
+
+    return source;
+}
+
+SourcePtr Source::mapFile(const QString &fileName, QString *errorString)
+{
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::ReadOnly)) {
+        if (errorString != nullptr) {
+            *errorString = file->errorString();
+        }
+        return nullptr;
+    }
+
+    const auto size = file->size();
+    if (size == 0) {
+        if (errorString != nullptr) {
+            *errorString = QLatin1String("empty file");
+        }
+        return nullptr;
+    }
+
+    auto *data = file->map(0, size);
+    if (data == nullptr) {
+        if (errorString != nullptr) {
+            *errorString = file->errorString();
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Source> source(new Source);
+    source->m_view = QByteArrayView(reinterpret_cast<const char *>(data), size);
+    source->m_file = std::move(file);
+
+    return source;
+}
+
+} // namespace trace
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
+#include <QtCore/QFile>
+
+namespace trace {
+
+class Source;
+using SourcePtr = std::shared_ptr<const Source>;
+
+/*!
+ * Bytes of a trace document, either held in memory or mapped from a file.
+ *
+ * Parsed traces reference strings inside the source instead of copying them
+ * and keep a SourcePtr, so the bytes live as long as any trace built from
+ * them. Strings that had to be decoded are kept by the source as well.
+ */
+class Source
+{
+public:
+    ~Source();
+
+    //! shares data, nothing is copied
+    static SourcePtr fromData(const QByteArray &data);
+    //! map the whole file read-only, nullptr on failure
+    static SourcePtr mapFile(const QString &fileName, QString *errorString = nullptr);
+
+    QByteArrayView data() const noexcept { return m_view; }
+    bool isMapped() const noexcept { return m_file != nullptr; }
+
+    //! copy bytes into storage that lives as long as the source, thread-safe
+    QByteArrayView keep(QByteArrayView bytes) const;
+
+private:
+    Source() = default;
+
+private:
+    QByteArray m_data;
+    std::unique_ptr<QFile> m_file;
+    QByteArrayView m_view;
+
+    mutable std::mutex m_mutex;
+    mutable std::vector<std::unique_ptr<char[]>> m_chunks;
+    mutable qsizetype m_chunkUsed = 0;
+    mutable std::vector<std::unique_ptr<char[]>> m_large;
+};
+
+} // namespace trace
@@ -3,13 +3,16 @@
 #include <chrono>
 
 #include <QtCore/QDateTime>
-#include <QtCore/QVariant>
 #include <QtCore/QVector>
 
+#include "id.h"
+#include "string_ref.h"
 #include "tag.h"
 
 namespace trace {
 
+class Source;
+
 using TimePoint = std::chrono::time_point<std::chrono::system_clock, std::chrono::microseconds>;
 
 struct SpanReference
@@ -17,35 +20,43 @@ struct SpanReference
     enum class Type { ChildOf };
 
     Type refType;
-    QString traceID;
-    QString spanID;
+    TraceID traceID;
+    SpanID spanID;
 };
 
+//! keys of one log, its fields stay undecoded in the trace source until they are shown
 struct LogRecord
 {
     TimePoint timestamp;
+    //! text of the 'level' field, empty without one
+    QByteArrayView level;
+    //! one of the fields is 'error'
+    bool hasError = false;
+    //! undecoded 'fields' array, see parseFields
+    QByteArrayView rawFields;
 
     struct Field
     {
-        QString key;
-        QVariant value;
+        Symbol key;
+        Value value;
     };
 
-    QVector<Field> fields;
+    //! decode rawFields, escaped strings are kept by keeper
+    static QVector<Field> parseFields(const Source &keeper, QByteArrayView rawFields);
 };
 
 struct Span
 {
-    QString traceID;
-    QString spanID;
+    TraceID traceID;
+    SpanID spanID;
     int flags;
-    QString operationName;
+    Symbol operationName;
     std::vector<SpanReference> references;
     TimePoint startTime;
     std::chrono::microseconds duration;
     Tags tags;
     QVector<LogRecord> logs;
-    QString processID;
+    StringRef processID;
 
     bool isEmpty() const noexcept;
 };
@@ -0,0 +1,20 @@
+#include "string_ref.h"
+
+namespace trace {
+
+StringRef StringRef::view(QByteArrayView utf8)
+{
+    return StringRef(QByteArray::fromRawData(utf8.data(), utf8.size()));
+}
+
+StringRef StringRef::copy(QByteArrayView utf8)
+{
+    return StringRef(utf8.toByteArray());
+}
+
+QString StringRef::toString() const
+{
+    return QString::fromUtf8(m_data);
+}
+
+} // namespace trace
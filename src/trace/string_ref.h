@@ -0,0 +1,63 @@
+#pragma once
+
+#include <utility>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
+#include <QtCore/QHashFunctions>
+#include <QtCore/QMetaType>
+#include <QtCore/QString>
+
+namespace trace {
+
+/*!
+ * UTF-8 string of a parsed document.
+ *
+ * Most strings point straight into the bytes of the Source they were parsed
+ * from, only strings with escapes own a decoded copy. The Source must outlive
+ * every view, trace::Trace and graph::Trace keep it alive for that reason.
+ */
+class StringRef
+{
+public:
+    StringRef() = default;
+
+    //! nothing is copied, data must stay valid while the reference is used
+    static StringRef view(QByteArrayView utf8);
+    static StringRef copy(QByteArrayView utf8);
+
+    bool isEmpty() const noexcept { return m_data.isEmpty(); }
+    qsizetype size() const noexcept { return m_data.size(); }
+    QByteArrayView utf8() const noexcept { return m_data; }
+
+    //! decode on demand, result is not cached
+    QString toString() const;
+
+    friend bool operator==(const StringRef &a, const StringRef &b) noexcept
+    {
+        return a.m_data == b.m_data;
+    }
+    friend bool operator!=(const StringRef &a, const StringRef &b) noexcept
+    {
+        return a.m_data != b.m_data;
+    }
+    friend bool operator==(const StringRef &a, const char *b) noexcept { return a.m_data == b; }
+    friend bool operator!=(const StringRef &a, const char *b) noexcept { return a.m_data != b; }
+
+private:
+    explicit StringRef(QByteArray data) noexcept
+        : m_data(std::move(data))
+    {}
+
+private:
+    QByteArray m_data;
+};
+
+inline size_t qHash(const StringRef &ref, size_t seed = 0) noexcept
+{
+    return qHash(ref.utf8(), seed);
+}
+
+} // namespace trace
+
+Q_DECLARE_METATYPE(trace::StringRef)
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define JGV_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JGV_TARGET(arch) __attribute__((target(arch)))
+#else
+#define JGV_TARGET(arch)
+#endif
+
+#include "structural_scanner.h"
+
+namespace {
+
+struct BlockMasks
+{
+    uint64_t quote = 0;
+    uint64_t backslash = 0;
+    uint64_t op = 0;
+    uint64_t whitespace = 0;
+    uint64_t control = 0;
+};
+
+enum CharClass : uint8_t {
+    Quote = 1,
+    Backslash = 2,
+    Op = 4,
+    Whitespace = 8,
+    Control = 16,
+};
+
+constexpr std::array<uint8_t, 256> makeClassTable()
+{
+    std::array<uint8_t, 256> table{};
+    for (int c = 0; c < 0x20; ++c) {
+        table[c] = Control;
+    }
+    table['"'] = Quote;
+    table['\\'] = Backslash;
+    table['{'] = Op;
+    table['}'] = Op;
+    table['['] = Op;
+    table[']'] = Op;
+    table[':'] = Op;
+    table[','] = Op;
+    table[' '] = Whitespace;
+    table['\t'] = Whitespace | Control;
+    table['\n'] = Whitespace | Control;
+    table['\r'] = Whitespace | Control;
+    return table;
+}
+
+constexpr auto ClassTable = makeClassTable();
+
+BlockMasks classifyScalar(const uint8_t *block)
+{
+    BlockMasks masks;
+    for (int i = 0; i < 64; ++i) {
+        const auto cls = ClassTable[block[i]];
+        const uint64_t bit = uint64_t(1) << i;
+        if (cls & Quote) {
+            masks.quote |= bit;
+        }
+        if (cls & Backslash) {
+            masks.backslash |= bit;
+        }
+        if (cls & Op) {
+            masks.op |= bit;
+        }
+        if (cls & Whitespace) {
+            masks.whitespace |= bit;
+        }
+        if (cls & Control) {
+            masks.control |= bit;
+        }
+    }
+    return masks;
+}
+
+#ifdef JGV_X86
+
+JGV_TARGET("sse4.2")
+BlockMasks classifySse42(const uint8_t *block)
+{
+    const __m128i ops = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i spaces = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i controlMax = _mm_set1_epi8(0x1F);
+
+    constexpr int Mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+
+    BlockMasks masks;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16));
+        const int shift = i * 16;
+
+        const auto opMask = _mm_cvtsi128_si32(_mm_cmpestrm(ops, 6, chunk, 16, Mode));
+        const auto wsMask = _mm_cvtsi128_si32(_mm_cmpestrm(spaces, 4, chunk, 16, Mode));
+        const auto quoteMask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote));
+        const auto bsMask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash));
+        const auto ctrlMask = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, controlMax), controlMax));
+
+        masks.op |= uint64_t(uint16_t(opMask)) << shift;
+        masks.whitespace |= uint64_t(uint16_t(wsMask)) << shift;
+        masks.quote |= uint64_t(uint16_t(quoteMask)) << shift;
+        masks.backslash |= uint64_t(uint16_t(bsMask)) << shift;
+        masks.control |= uint64_t(uint16_t(ctrlMask)) << shift;
+    }
+    return masks;
+}
+
+JGV_TARGET("avx2")
+inline __m256i eq(__m256i chunk, char c)
+{
+    return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c));
+}
+
+JGV_TARGET("avx2")
+BlockMasks classifyAvx2(const uint8_t *block)
+{
+    const __m256i controlMax = _mm256_set1_epi8(0x1F);
+
+    BlockMasks masks;
+    for (int i = 0; i < 2; ++i) {
+        const __m256i chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(block + i * 32));
+        const int shift = i * 32;
+
+        const __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(eq(chunk, '{'), eq(chunk, '}')),
+                            _mm256_or_si256(eq(chunk, '['), eq(chunk, ']'))),
+            _mm256_or_si256(eq(chunk, ':'), eq(chunk, ',')));
+        const __m256i ws = _mm256_or_si256(_mm256_or_si256(eq(chunk, ' '), eq(chunk, '\t')),
+                                           _mm256_or_si256(eq(chunk, '\n'), eq(chunk, '\r')));
+        const __m256i ctrl = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, controlMax), controlMax);
+
+        masks.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << shift;
+        masks.whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << shift;
+        masks.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(eq(chunk, '"')))) << shift;
+        masks.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(eq(chunk, '\\')))) << shift;
+        masks.control |= uint64_t(uint32_t(_mm256_movemask_epi8(ctrl))) << shift;
+    }
+    return masks;
+}
+
+#endif
+
+BlockMasks classify(trace::StructuralScanner::Implementation implementation, const uint8_t *block)
+{
+#ifdef JGV_X86
+    switch (implementation) {
+    case trace::StructuralScanner::Implementation::Avx2:
+        return classifyAvx2(block);
+    case trace::StructuralScanner::Implementation::Sse42:
+        return classifySse42(block);
+    case trace::StructuralScanner::Implementation::Scalar:
+        break;
+    }
+#else
+    (void) implementation;
+#endif
+    return classifyScalar(block);
+}
+
+//! bit i is the xor of bits [0, i]
+uint64_t prefixXor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+//! characters preceded by an odd-length run of backslashes
+uint64_t escapedCharacters(uint64_t backslash, uint64_t &prevOddBackslash)
+{
+    constexpr uint64_t EvenBits = 0x5555555555555555ULL;
+    constexpr uint64_t OddBits = ~EvenBits;
+
+    const uint64_t startEdges = backslash & ~(backslash << 1);
+    const uint64_t evenStartMask = EvenBits ^ prevOddBackslash;
+    const uint64_t evenStarts = startEdges & evenStartMask;
+    const uint64_t oddStarts = startEdges & ~evenStartMask;
+    const uint64_t evenCarries = backslash + evenStarts;
+
+    uint64_t oddCarries = backslash + oddStarts;
+    const bool endsOddBackslash = oddCarries < backslash;
+    oddCarries |= prevOddBackslash;
+    prevOddBackslash = endsOddBackslash ? 1 : 0;
+
+    const uint64_t evenCarryEnds = evenCarries & ~backslash;
+    const uint64_t oddCarryEnds = oddCarries & ~backslash;
+
+    return (evenCarryEnds & OddBits) | (oddCarryEnds & EvenBits);
+}
+
+int trailingZeros(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index = 0;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    int n = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+} // namespace
+
+namespace trace {
+
+StructuralScanner::Implementation StructuralScanner::bestImplementation() noexcept
+{
+#if defined(JGV_X86) && (defined(__GNUC__) || defined(__clang__))
+    static const auto best = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Implementation::Avx2;
+        }
+        if (__builtin_cpu_supports("sse4.2")) {
+            return Implementation::Sse42;
+        }
+        return Implementation::Scalar;
+    }();
+    return best;
+#elif defined(JGV_X86) && defined(_MSC_VER)
+    static const auto best = []() {
+        int info[4] = {};
+        __cpuid(info, 1);
+        const bool sse42 = (info[2] & (1 << 20)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        __cpuidex(info, 7, 0);
+        const bool avx2 = (info[1] & (1 << 5)) != 0;
+
+        if (osxsave && avx && avx2 && (_xgetbv(0) & 0x6) == 0x6) {
+            return Implementation::Avx2;
+        }
+        if (sse42) {
+            return Implementation::Sse42;
+        }
+        return Implementation::Scalar;
+    }();
+    return best;
+#else
+    return Implementation::Scalar;
+#endif
+}
+
+StructuralScanner::StructuralScanner(std::string_view data, Implementation implementation)
+    : m_data(reinterpret_cast<const uint8_t *>(data.data()))
+    , m_size(data.size())
+    , m_offset(0)
+    , m_implementation(implementation)
+    , m_prevInString(0)
+    , m_prevOddBackslash(0)
+    , m_prevScalarPredecessor(1)
+    , m_hasError(false)
+    , m_errorOffset(0)
+{}
+
+bool StructuralScanner::scan(std::vector<uint64_t> &positions)
+{
+    positions.clear();
+    if (m_offset >= m_size) {
+        return false;
+    }
+
+    const uint64_t windowEnd = std::min<uint64_t>(m_offset + WindowSize, m_size);
+
+    uint8_t tail[64];
+    for (; m_offset < windowEnd; m_offset += 64) {
+        const uint8_t *block = m_data + m_offset;
+        if (m_size - m_offset < 64) {
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, m_size - m_offset);
+            block = tail;
+        }
+
+        const auto masks = classify(m_implementation, block);
+
+        const uint64_t escaped = escapedCharacters(masks.backslash, m_prevOddBackslash);
+        const uint64_t quote = masks.quote & ~escaped;
+
+        // opening quote and string content are set, closing quote is not
+        const uint64_t inString = prefixXor(quote) ^ m_prevInString;
+        m_prevInString = uint64_t(int64_t(inString) >> 63);
+
+        const uint64_t badControl = masks.control & inString & ~quote;
+        if (badControl != 0 && !m_hasError) {
+            m_hasError = true;
+            m_errorOffset = m_offset + trailingZeros(badControl);
+        }
+
+        const uint64_t op = masks.op & ~inString;
+        const uint64_t predecessor = op | quote | (masks.whitespace & ~inString);
+        const uint64_t scalar = ~(masks.whitespace | masks.op | quote | inString);
+        const uint64_t scalarStart = ((predecessor << 1) | m_prevScalarPredecessor) & scalar;
+        m_prevScalarPredecessor = predecessor >> 63;
+
+        uint64_t structural = op | quote | scalarStart;
+        while (structural != 0) {
+            positions.push_back(m_offset + trailingZeros(structural));
+            structural &= structural - 1;
+        }
+    }
+
+    if (m_offset > m_size) {
+        m_offset = m_size;
+    }
+
+    return true;
+}
+
+bool StructuralScanner::hasError() const noexcept
+{
+    return m_hasError;
+}
+
+uint64_t StructuralScanner::errorOffset() const noexcept
+{
+    return m_errorOffset;
+}
+
+StructuralScanner::Implementation StructuralScanner::implementation() const noexcept
+{
+    return m_implementation;
+}
+
+} // namespace trace
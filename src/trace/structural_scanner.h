@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace trace {
+
+/*!
+ * Vectorized first pass over JSON text.
+ *
+ * The scanner classifies the input 64 bytes at a time and reports offsets of
+ * structural characters ({}[]:,), of both quotes of every string and of the
+ * first character of every number or literal. Escaped quotes and everything
+ * inside strings are left out, so JsonReader can jump from token to token
+ * without looking at the bytes in between.
+ *
+ * The input is indexed window by window to keep memory bounded on large
+ * documents.
+ */
+class StructuralScanner
+{
+public:
+    enum class Implementation { Scalar, Sse42, Avx2 };
+
+    static constexpr size_t WindowSize = 64 * 1024;
+
+    static Implementation bestImplementation() noexcept;
+
+    explicit StructuralScanner(std::string_view data,
+                               Implementation implementation = bestImplementation());
+
+    //! replace positions with the offsets of the next window, false when the input is exhausted
+    bool scan(std::vector<uint64_t> &positions);
+
+    //! unescaped control character inside a string
+    bool hasError() const noexcept;
+    uint64_t errorOffset() const noexcept;
+
+    Implementation implementation() const noexcept;
+
+private:
+    const uint8_t *m_data;
+    uint64_t m_size;
+    uint64_t m_offset;
+    Implementation m_implementation;
+
+    uint64_t m_prevInString;
+    uint64_t m_prevOddBackslash;
+    uint64_t m_prevScalarPredecessor;
+
+    bool m_hasError;
+    uint64_t m_errorOffset;
+};
+
+} // namespace trace
@@ -0,0 +1,141 @@
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <QtCore/QtGlobal>
+
+#include "symbol.h"
+
+namespace {
+
+class SymbolTable
+{
+public:
+    static constexpr quint32 ChunkBits = 12;
+    static constexpr quint32 ChunkSize = 1u << ChunkBits;
+    static constexpr quint32 MaxChunks = 1u << 14;
+
+    static SymbolTable &instance()
+    {
+        static SymbolTable table;
+        return table;
+    }
+
+    SymbolTable()
+    {
+        for (auto &chunk : m_chunks) {
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
+
+        // id 0 is the empty string
+        insert(std::string_view());
+    }
+
+    ~SymbolTable()
+    {
+        for (auto &chunk : m_chunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    quint32 intern(std::string_view utf8)
+    {
+        // parser workers intern the same keys over and over, look them up without the lock
+        thread_local std::unordered_map<std::string_view, quint32> cache;
+
+        auto cached = cache.find(utf8);
+        if (cached != cache.end()) {
+            return cached->second;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto iter = m_ids.find(utf8);
+        const quint32 id = iter != m_ids.end() ? iter->second : insert(utf8);
+        cache.emplace(m_utf8[id], id);
+
+        return id;
+    }
+
+    const QString &string(quint32 id) const noexcept { return entry(id).string; }
+    std::string_view utf8(quint32 id) const noexcept { return entry(id).utf8; }
+
+private:
+    struct Entry
+    {
+        QString string;
+        std::string_view utf8;
+    };
+
+    const Entry &entry(quint32 id) const noexcept
+    {
+        const auto chunk = m_chunks[id >> ChunkBits].load(std::memory_order_acquire);
+        return chunk[id & (ChunkSize - 1)];
+    }
+
+    quint32 insert(std::string_view utf8)
+    {
+        const auto id = static_cast<quint32>(m_utf8.size());
+        const auto chunkIndex = id >> ChunkBits;
+        if (chunkIndex >= MaxChunks) {
+            qFatal("symbol table overflow");
+        }
+
+        auto chunk = m_chunks[chunkIndex].load(std::memory_order_relaxed);
+        if (chunk == nullptr) {
+            chunk = new Entry[ChunkSize];
+        }
+
+        // deque keeps strings in place, entries, map keys and thread caches point into them
+        const auto &stored = m_utf8.emplace_back(utf8);
+        m_ids.emplace(stored, id);
+
+        auto &entry = chunk[id & (ChunkSize - 1)];
+        entry.string = QString::fromUtf8(utf8.data(), static_cast<qsizetype>(utf8.size()));
+        entry.utf8 = stored;
+        m_chunks[chunkIndex].store(chunk, std::memory_order_release);
+
+        return id;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::array<std::atomic<Entry *>, MaxChunks> m_chunks;
+    std::deque<std::string> m_utf8;
+    std::unordered_map<std::string_view, quint32> m_ids;
+};
+
+} // namespace
+
+namespace trace {
+
+Symbol Symbol::intern(std::string_view utf8)
+{
+    if (utf8.empty()) {
+        return {};
+    }
+
+    return Symbol(SymbolTable::instance().intern(utf8));
+}
+
+Symbol Symbol::intern(const QString &str)
+{
+    const auto utf8 = str.toUtf8();
+    return intern(std::string_view(utf8.constData(), static_cast<size_t>(utf8.size())));
+}
+
+const QString &Symbol::toString() const noexcept
+{
+    return SymbolTable::instance().string(m_id);
+}
+
+QByteArrayView Symbol::utf8() const noexcept
+{
+    const auto utf8 = SymbolTable::instance().utf8(m_id);
+    return QByteArrayView(utf8.data(), static_cast<qsizetype>(utf8.size()));
+}
+
+} // namespace trace
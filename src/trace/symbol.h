@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string_view>
+
+#include <QtCore/QByteArrayView>
+#include <QtCore/QHashFunctions>
+#include <QtCore/QMetaType>
+#include <QtCore/QString>
+
+namespace trace {
+
+//! interned string, equal strings share one id for the whole process lifetime
+class Symbol
+{
+public:
+    Symbol() = default;
+
+    static Symbol intern(std::string_view utf8);
+    static Symbol intern(const char *utf8) { return intern(std::string_view(utf8)); }
+    static Symbol intern(const QString &str);
+
+    quint32 id() const noexcept { return m_id; }
+    bool isEmpty() const noexcept { return m_id == 0; }
+
+    //! reference stays valid until the process exits
+    const QString &toString() const noexcept;
+    //! bytes stay valid until the process exits
+    QByteArrayView utf8() const noexcept;
+
+    friend bool operator==(Symbol a, Symbol b) noexcept { return a.m_id == b.m_id; }
+    friend bool operator!=(Symbol a, Symbol b) noexcept { return a.m_id != b.m_id; }
+    //! order of interning, not alphabetical
+    friend bool operator<(Symbol a, Symbol b) noexcept { return a.m_id < b.m_id; }
+
+private:
+    explicit Symbol(quint32 id) noexcept
+        : m_id(id)
+    {}
+
+private:
+    quint32 m_id = 0;
+};
+
+inline size_t qHash(Symbol symbol, size_t seed = 0) noexcept
+{
+    return ::qHash(symbol.id(), seed);
+}
+
+} // namespace trace
+
+Q_DECLARE_METATYPE(trace::Symbol)
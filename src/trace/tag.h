@@ -1,15 +1,17 @@
 #pragma once
 
 #include <QtCore/QString>
-#include <QtCore/QVariant>
 #include <QtCore/QVector>
 
+#include "symbol.h"
+#include "value.h"
+
 namespace trace {
 
 struct Tag
 {
-    QString key;
-    QVariant value;
+    Symbol key;
+    Value value;
 };
 
 using Tags = QVector<Tag>;
@@ -1,7 +1,7 @@
-#include <QtCore/QJsonArray>
-#include <QtCore/QJsonDocument>
-#include <QtCore/QJsonObject>
+#include <QtCore/QDebug>
 
+#include "json_reader.h"
+#include "parallel.h"
 #include "trace.h"
 
 namespace {
@@ -13,154 +13,478 @@ void setError(trace::TraceParseError *error, trace::TraceParseError::ParseError
     }
 }
 
-std::vector<trace::SpanReference> parseSpanReference(const QJsonArray &array,
-                                                     trace::TraceParseError *error)
+QString readString(trace::JsonReader &reader)
 {
-    if (array.isEmpty()) {
+    std::string_view value;
+    if (!reader.readString(&value)) {
         return {};
     }
 
-    std::vector<trace::SpanReference> refs;
-    refs.reserve(array.size());
+    return QString::fromUtf8(value.data(), static_cast<qsizetype>(value.size()));
+}
 
-    for (auto jRef : array) {
-        if (!jRef.isObject()) {
-            setError(error, trace::TraceParseError::ParseError::InvalidJSON);
-            qWarning() << "invalid trace, expected object in references list";
-            return {};
+//! strings with escapes are decoded into reader scratch memory, the source keeps a copy
+QByteArrayView keep(const trace::JsonReader &reader,
+                    const trace::Source &source,
+                    std::string_view value)
+{
+    const QByteArrayView utf8(value.data(), static_cast<qsizetype>(value.size()));
+    return reader.isInput(value) ? utf8 : source.keep(utf8);
+}
+
+trace::StringRef readRef(trace::JsonReader &reader, const trace::Source &source)
+{
+    std::string_view value;
+    if (!reader.readString(&value)) {
+        return {};
+    }
+
+    return trace::StringRef::view(keep(reader, source, value));
+}
+
+//! hex IDs are decoded right away, malformed ones become empty
+trace::SpanID readSpanID(trace::JsonReader &reader)
+{
+    std::string_view value;
+    if (!reader.readString(&value)) {
+        return {};
+    }
+
+    return trace::SpanID::fromHex(value);
+}
+
+trace::TraceID readTraceID(trace::JsonReader &reader)
+{
+    std::string_view value;
+    if (!reader.readString(&value)) {
+        return {};
+    }
+
+    return trace::TraceID::fromHex(value);
+}
+
+trace::Symbol readSymbol(trace::JsonReader &reader)
+{
+    std::string_view value;
+    if (!reader.readString(&value)) {
+        return {};
+    }
+
+    return trace::Symbol::intern(value);
+}
+
+qint64 readInteger(trace::JsonReader &reader)
+{
+    int64_t value = 0;
+    if (!reader.readInt64(&value)) {
+        return 0;
+    }
+
+    return value;
+}
+
+//! value of tag or log field, type is known only after the whole object is read
+struct RawValue
+{
+    trace::JsonReader::Token token = trace::JsonReader::Token::Null;
+    //! string or number text, lives as long as the source
+    QByteArrayView text;
+    bool boolean = false;
+
+    std::string_view view() const
+    {
+        return std::string_view(text.data(), static_cast<size_t>(text.size()));
+    }
+};
+
+RawValue readRawValue(trace::JsonReader &reader, const trace::Source &source)
+{
+    RawValue raw;
+    raw.token = reader.peek();
+
+    std::string_view text;
+    switch (raw.token) {
+    case trace::JsonReader::Token::String:
+        if (reader.readString(&text)) {
+            raw.text = keep(reader, source, text);
+        }
+        break;
+    case trace::JsonReader::Token::Number:
+        if (reader.readNumber(&text)) {
+            raw.text = QByteArrayView(text.data(), static_cast<qsizetype>(text.size()));
         }
+        break;
+    case trace::JsonReader::Token::Bool:
+        reader.readBool(&raw.boolean);
+        break;
+    default:
+        reader.skipValue();
+        break;
+    }
+
+    return raw;
+}
 
-        auto jObj = jRef.toObject();
-        if (jObj["refType"].toString() != "CHILD_OF") {
-            qCritical() << "invalid trace, unknown refType" << jObj["refType"].toString();
+//! value of unknown type is kept as it is in json
+trace::Value untypedValue(const RawValue &raw)
+{
+    switch (raw.token) {
+    case trace::JsonReader::Token::String:
+        return trace::Value::fromView(raw.text);
+    case trace::JsonReader::Token::Number: {
+        int64_t integer = 0;
+        if (trace::JsonReader::toInt64(raw.view(), &integer)) {
+            return trace::Value::fromInt64(integer);
         }
+
+        double number = 0;
+        trace::JsonReader::toDouble(raw.view(), &number);
+        return trace::Value::fromDouble(number);
+    }
+    case trace::JsonReader::Token::Bool:
+        return trace::Value::fromBool(raw.boolean);
+    default:
+        return {};
+    }
+}
+
+//! key, type and value may come in any order
+bool parseKeyValue(trace::JsonReader &reader,
+                   const trace::Source &source,
+                   trace::Symbol *key,
+                   trace::Value *value,
+                   const char *what)
+{
+    if (!reader.beginObject()) {
+        return false;
+    }
+
+    using Token = trace::JsonReader::Token;
+
+    static const auto stringType = trace::Symbol::intern("string");
+    static const auto int64Type = trace::Symbol::intern("int64");
+    static const auto float64Type = trace::Symbol::intern("float64");
+    static const auto boolType = trace::Symbol::intern("bool");
+    static const auto binaryType = trace::Symbol::intern("binary");
+
+    trace::Symbol type;
+    RawValue raw;
+
+    std::string_view name;
+    while (reader.nextKey(&name)) {
+        if (name == "key") {
+            *key = readSymbol(reader);
+        } else if (name == "type") {
+            type = readSymbol(reader);
+        } else if (name == "value") {
+            raw = readRawValue(reader, source);
+        } else {
+            reader.skipValue();
+        }
+    }
+
+    if (type == stringType || type == binaryType) {
+        const auto valueType = type == stringType ? trace::Value::Type::String
+                                                  : trace::Value::Type::Binary;
+        const auto text = raw.token == Token::String ? raw.text : QByteArrayView();
+        *value = trace::Value::fromView(text, valueType);
+    } else if (type == int64Type) {
+        int64_t integer = 0;
+        if (raw.token == Token::Number) {
+            trace::JsonReader::toInt64(raw.view(), &integer);
+        }
+        *value = trace::Value::fromInt64(integer);
+    } else if (type == float64Type) {
+        double number = 0;
+        if (raw.token == Token::Number) {
+            trace::JsonReader::toDouble(raw.view(), &number);
+        }
+        *value = trace::Value::fromDouble(number);
+    } else if (type == boolType) {
+        *value = trace::Value::fromBool(raw.token == Token::Bool && raw.boolean);
+    } else {
+        qWarning() << what << type.toString();
+        *value = untypedValue(raw);
+    }
+
+    return true;
+}
+
+std::vector<trace::SpanReference> parseSpanReference(trace::JsonReader &reader,
+                                                     const trace::Source &source,
+                                                     trace::TraceParseError *error)
+{
+    std::vector<trace::SpanReference> refs;
+    if (!reader.beginArray()) {
+        return refs;
+    }
+
+    bool valid = true;
+    while (reader.nextElement()) {
+        if (!reader.beginObject()) {
+            if (valid) {
+                setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+                qWarning() << "invalid trace, expected object in references list";
+            }
+            valid = false;
+            continue;
+        }
+
         trace::SpanReference ref;
         ref.refType = trace::SpanReference::Type::ChildOf;
-        ref.traceID = jObj["traceID"].toString();
-        ref.spanID = jObj["spanID"].toString();
+
+        std::string_view key;
+        while (reader.nextKey(&key)) {
+            if (key == "refType") {
+                const auto refType = readString(reader);
+                if (refType != "CHILD_OF") {
+                    qCritical() << "invalid trace, unknown refType" << refType;
+                }
+            } else if (key == "traceID") {
+                ref.traceID = readTraceID(reader);
+            } else if (key == "spanID") {
+                ref.spanID = readSpanID(reader);
+            } else {
+                reader.skipValue();
+            }
+        }
+
         refs.emplace_back(ref);
     }
 
+    if (!valid) {
+        return {};
+    }
+
     return refs;
 }
 
-trace::Tags parseTags(const QJsonArray &array, trace::TraceParseError *error)
+trace::Tags parseTags(trace::JsonReader &reader,
+                      const trace::Source &source,
+                      trace::TraceParseError *error)
 {
-    if (array.isEmpty()) {
-        return {};
-    }
+    Q_UNUSED(error)
 
     trace::Tags tags;
-    tags.reserve(array.size());
-    for (auto item : array) {
-        auto jObj = item.toObject();
+    if (!reader.beginArray()) {
+        return tags;
+    }
 
+    while (reader.nextElement()) {
         trace::Tag tag;
-        tag.key = jObj["key"].toString();
-
-        const auto tagType = jObj["type"].toString();
-        const auto value = jObj["value"];
-
-        if (tagType == "string") {
-            tag.value = value.toString();
-        } else if (tagType == "int64") {
-            tag.value = value.toInteger();
-        } else if (tagType == "bool") {
-            tag.value = value.toBool();
-        } else {
-            qCritical() << "Unknown tag type" << tagType;
+        if (parseKeyValue(reader, source, &tag.key, &tag.value, "Unknown tag type")) {
+            tags.emplace_back(tag);
         }
-
-        tags.emplace_back(tag);
     }
+
     return tags;
 }
 
-QVector<trace::LogRecord> parseLogs(const QJsonArray &array, trace::TraceParseError *error)
+//! the 'level' and 'error' fields of a log, values of the others are not read
+bool parseLogKeys(const trace::Source &source, QByteArrayView rawFields, trace::LogRecord *record)
 {
-    if (array.isEmpty()) {
-        return {};
+    trace::JsonReader reader(
+        std::string_view(rawFields.data(), static_cast<size_t>(rawFields.size())));
+    if (!reader.beginArray()) {
+        return false;
     }
 
-    QVector<trace::LogRecord> logs;
-    logs.reserve(array.size());
+    std::string_view name;
+    while (reader.nextElement()) {
+        if (!reader.beginObject()) {
+            return false;
+        }
 
-    for (auto item : array) {
-        auto jObj = item.toObject();
+        bool isLevel = false;
+        std::string_view rawValue;
+        while (reader.nextKey(&name)) {
+            if (name == "key") {
+                std::string_view key;
+                if (reader.readString(&key)) {
+                    isLevel = key == "level";
+                    record->hasError = record->hasError || key == "error";
+                }
+            } else if (name == "value") {
+                reader.skipValue(&rawValue);
+            } else {
+                reader.skipValue();
+            }
+        }
 
-        trace::LogRecord lr;
-        lr.timestamp = trace::TimePoint(std::chrono::microseconds(jObj["timestamp"].toInteger()));
+        if (isLevel && !rawValue.empty() && rawValue.front() == '"') {
+            trace::JsonReader value(rawValue);
+            std::string_view text;
+            if (value.readString(&text)) {
+                record->level = keep(value, source, text);
+            }
+        }
+    }
 
-        QVector<trace::LogRecord::Field> fields;
-        auto jFields = jObj["fields"].toArray();
-        fields.reserve(jFields.size());
+    return reader.atEnd();
+}
 
-        for (auto fieldItem : jFields) {
-            auto jFieldObj = fieldItem.toObject();
-            trace::LogRecord::Field field;
-            field.key = jFieldObj["key"].toString();
-            const auto fieldType = jFieldObj["type"].toString();
-            const auto value = jFieldObj["value"];
+//! timestamps and keys of the logs, false when the array is not the one parseFields reads
+bool parseLogs(trace::JsonReader &reader,
+               const trace::Source &source,
+               QVector<trace::LogRecord> *logs)
+{
+    if (reader.peek() == trace::JsonReader::Token::Null) {
+        return reader.skipValue();
+    }
+    if (!reader.beginArray()) {
+        return false;
+    }
+
+    bool valid = true;
+    while (reader.nextElement()) {
+        if (!reader.beginObject()) {
+            valid = false;
+            continue;
+        }
 
-            if (fieldType == "string") {
-                field.value = value.toString();
-            } else if (fieldType == "int64") {
-                field.value = value.toInteger();
-            } else if (fieldType == "bool") {
-                field.value = value.toBool();
+        trace::LogRecord record;
+        std::string_view key;
+        while (reader.nextKey(&key)) {
+            if (key == "timestamp") {
+                const auto timestamp = std::chrono::microseconds(readInteger(reader));
+                record.timestamp = trace::TimePoint(timestamp);
+            } else if (key == "fields") {
+                std::string_view rawFields;
+                reader.skipValue(&rawFields);
+                record.rawFields = QByteArrayView(rawFields.data(),
+                                                  static_cast<qsizetype>(rawFields.size()));
+                valid = parseLogKeys(source, record.rawFields, &record) && valid;
             } else {
-                qCritical() << "Unknown log field type " << fieldType;
+                reader.skipValue();
             }
-            fields.emplace_back(field);
         }
 
-        lr.fields.swap(fields);
-        logs.emplace_back(lr);
+        logs->emplace_back(record);
     }
 
-    return logs;
+    return valid;
 }
 
-trace::Span parseSpan(const QJsonObject &spanObj, trace::TraceParseError *error)
+trace::Span parseSpan(trace::JsonReader &reader,
+                      const trace::Source &source,
+                      trace::TraceParseError *error)
 {
     trace::Span span;
+    span.flags = 0;
+    span.duration = std::chrono::microseconds(0);
+
+    if (!reader.beginObject()) {
+        return span;
+    }
 
-    span.traceID = spanObj["traceID"].toString();
-    span.spanID = spanObj["spanID"].toString();
-    span.flags = spanObj["flags"].toInt();
-    span.operationName = spanObj["operationName"].toString();
-    span.references = std::move(parseSpanReference(spanObj["references"].toArray(), error));
-    span.startTime = trace::TimePoint(std::chrono::microseconds(spanObj["startTime"].toInteger()));
-    span.duration = std::chrono::microseconds(spanObj["duration"].toInteger());
-    span.tags = std::move(parseTags(spanObj["tags"].toArray(), error));
-    span.logs = std::move(parseLogs(spanObj["logs"].toArray(), error));
-    span.processID = spanObj["processID"].toString();
+    bool validLogs = true;
+    std::string_view key;
+    while (reader.nextKey(&key)) {
+        if (key == "traceID") {
+            span.traceID = readTraceID(reader);
+        } else if (key == "spanID") {
+            span.spanID = readSpanID(reader);
+        } else if (key == "flags") {
+            span.flags = static_cast<int>(readInteger(reader));
+        } else if (key == "operationName") {
+            span.operationName = readSymbol(reader);
+        } else if (key == "references") {
+            span.references = parseSpanReference(reader, source, error);
+        } else if (key == "startTime") {
+            span.startTime = trace::TimePoint(std::chrono::microseconds(readInteger(reader)));
+        } else if (key == "duration") {
+            span.duration = std::chrono::microseconds(readInteger(reader));
+        } else if (key == "tags") {
+            span.tags = parseTags(reader, source, error);
+        } else if (key == "logs") {
+            // fields are decoded later on a worker, where a failure would never reach the user
+            validLogs = parseLogs(reader, source, &span.logs) && validLogs;
+        } else if (key == "processID") {
+            span.processID = readRef(reader, source);
+        } else {
+            reader.skipValue();
+        }
+    }
+
+    if (!validLogs) {
+        // an empty span fails the whole trace
+        qWarning() << "invalid trace, malformed span logs";
+        setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+        return trace::Span();
+    }
 
     return span;
 }
 
-QHash<QString, trace::Process> parseProcess(const QJsonObject &object, trace::TraceParseError *error)
+QHash<trace::StringRef, trace::Process> parseProcess(trace::JsonReader &reader,
+                                                     const trace::Source &source,
+                                                     trace::TraceParseError *error)
 {
-    QHash<QString, trace::Process> processes;
-    processes.reserve(object.size());
+    QHash<trace::StringRef, trace::Process> processes;
+    if (!reader.beginObject()) {
+        return processes;
+    }
 
-    for (auto iter = object.begin(); iter != object.end(); ++iter) {
-        const auto jObj = iter.value().toObject();
+    std::string_view processID;
+    while (reader.nextKey(&processID)) {
+        const auto id = trace::StringRef::view(keep(reader, source, processID));
         trace::Process process;
 
-        process.name = jObj["serviceName"].toString();
-        process.tags = std::move(parseTags(jObj["tags"].toArray(), error));
+        if (reader.beginObject()) {
+            std::string_view key;
+            while (reader.nextKey(&key)) {
+                if (key == "serviceName") {
+                    process.name = readSymbol(reader);
+                } else if (key == "tags") {
+                    process.tags = parseTags(reader, source, error);
+                } else {
+                    reader.skipValue();
+                }
+            }
+        }
 
-        processes.insert(iter.key(), std::move(process));
+        processes.insert(id, std::move(process));
     }
 
     return processes;
 }
 
-trace::Trace parseTrace(const QJsonObject &traceObj, trace::TraceParseError *error) noexcept
+trace::Trace readTrace(trace::JsonReader &reader,
+                       const trace::Source &source,
+                       trace::TraceParseError *error) noexcept
 {
     trace::Trace tr;
-    tr.traceID = traceObj["traceID"].toString();
+    bool validSpans = true;
+
+    std::string_view key;
+    while (reader.nextKey(&key)) {
+        if (key == "traceID") {
+            tr.traceID = readTraceID(reader);
+        } else if (key == "spans") {
+            if (!reader.beginArray()) {
+                continue;
+            }
+
+            while (reader.nextElement()) {
+                auto span = parseSpan(reader, source, error);
+                if (span.isEmpty()) {
+                    validSpans = false;
+                }
+
+                if (validSpans) {
+                    tr.spans.emplaceBack(std::move(span));
+                }
+            }
+        } else if (key == "processes") {
+            tr.process = parseProcess(reader, source, error);
+        } else {
+            reader.skipValue();
+        }
+    }
+
+    if (reader.hasError()) {
+        return {};
+    }
 
     if (tr.traceID.isEmpty()) {
         qWarning() << "invalid trace, empty traceID";
@@ -168,90 +492,249 @@ trace::Trace parseTrace(const QJsonObject &traceObj, trace::TraceParseError *err
         return {};
     }
 
-    auto jSpans = traceObj["spans"].toArray();
-    if (jSpans.isEmpty()) {
+    if (!validSpans) {
+        // a malformed ID decodes to an empty one, the trace must not vanish silently
+        qWarning() << "invalid trace, span without valid traceID or spanID";
+        setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+        return {};
+    }
+
+    if (tr.spans.isEmpty()) {
         qWarning() << "invalid trace, empty spans";
         setError(error, trace::TraceParseError::ParseError::InvalidJSON);
         return {};
     }
 
-    tr.spans.reserve(jSpans.size());
+    if (tr.process.isEmpty()) {
+        qWarning() << "invalid trace, empty processes";
+        setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+        return {};
+    }
 
-    for (auto jSpan : jSpans) {
-        auto span = parseSpan(jSpan.toObject(), error);
-        if (span.isEmpty()) {
-            return {};
+    return tr;
+}
+
+bool invalidJson(const trace::JsonReader &reader, trace::TraceParseError *error)
+{
+    setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+    qWarning() << "invalid trace json" << QString::fromStdString(reader.errorString())
+               << "at offset" << reader.offset();
+    return false;
+}
+
+//! walk the root object and call func for every element of the 'data' array
+template<typename Func>
+bool readDocument(trace::JsonReader &reader, trace::TraceParseError *error, Func &&func)
+{
+    if (!reader.beginObject()) {
+        if (reader.hasError()) {
+            return invalidJson(reader, error);
         }
 
-        tr.spans.emplaceBack(span);
+        qWarning() << "invalid trace json, expected object";
+        setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+        return false;
     }
 
-    auto jProceess = traceObj["processes"].toObject();
-    if (jProceess.isEmpty()) {
-        qWarning() << "invalid trace, empty processes";
+    bool hasData = false;
+
+    std::string_view key;
+    while (reader.nextKey(&key)) {
+        if (key != "data" || hasData) {
+            reader.skipValue();
+            continue;
+        }
+
+        hasData = true;
+        if (!reader.beginArray()) {
+            if (reader.hasError()) {
+                return invalidJson(reader, error);
+            }
+
+            qWarning() << "invalid trace json, data expected array";
+            setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+            return false;
+        }
+
+        while (reader.nextElement()) {
+            const auto token = reader.peek();
+            if (token != trace::JsonReader::Token::BeginObject) {
+                if (token == trace::JsonReader::Token::Error) {
+                    return invalidJson(reader, error);
+                }
+
+                qWarning() << "invalid trace json, data expected array of objects";
+                setError(error, trace::TraceParseError::ParseError::InvalidJSON);
+                return false;
+            }
+
+            func(reader);
+        }
+    }
+
+    if (!reader.atEnd()) {
+        return invalidJson(reader, error);
+    }
+
+    if (!hasData) {
+        qWarning() << "invalid trace json, data expected array";
         setError(error, trace::TraceParseError::ParseError::InvalidJSON);
-        return {};
+        return false;
     }
 
-    tr.process = std::move(parseProcess(jProceess, error));
-    return tr;
+    return true;
+}
+
+//! below this size building the structural index costs more than it saves
+constexpr qsizetype StructuralIndexThreshold = 4096;
+
+trace::JsonReader makeReader(QByteArrayView data)
+{
+    const std::string_view view(data.data(), static_cast<size_t>(data.size()));
+
+    const auto implementation = trace::StructuralScanner::bestImplementation();
+    if (data.size() >= StructuralIndexThreshold
+        && implementation != trace::StructuralScanner::Implementation::Scalar) {
+        return trace::JsonReader(view, implementation);
+    }
+
+    return trace::JsonReader(view);
 }
 
 } // namespace
 namespace trace {
 
+QVector<LogRecord::Field> LogRecord::parseFields(const Source &keeper, QByteArrayView rawFields)
+{
+    QVector<Field> fields;
+    JsonReader reader(std::string_view(rawFields.data(), static_cast<size_t>(rawFields.size())));
+    if (!reader.beginArray()) {
+        return fields;
+    }
+
+    while (reader.nextElement()) {
+        Field field;
+        if (parseKeyValue(reader, keeper, &field.key, &field.value, "Unknown log field type")) {
+            fields.emplace_back(field);
+        }
+    }
+
+    return fields;
+}
+
 bool Trace::isEmpty() const noexcept
 {
     return traceID.isEmpty() || spans.isEmpty();
 }
 
-TraceDocument TraceDocument::parseDocument(const QByteArray &data, TraceParseError *error) noexcept
+Trace Trace::parse(const SourcePtr &source, QByteArrayView data, TraceParseError *error) noexcept
 {
-    QJsonParseError jErr;
-    auto jDoc = QJsonDocument::fromJson(data, &jErr);
-
-    if (jErr.error != QJsonParseError::NoError) {
-        setError(error, TraceParseError::ParseError::InvalidJSON);
-        qWarning() << "invalid trace json" << jErr.errorString();
-        return {};
-    }
+    auto reader = makeReader(data);
+    if (!reader.beginObject()) {
+        if (reader.hasError()) {
+            invalidJson(reader, error);
+            return {};
+        }
 
-    if (!jDoc.isObject()) {
         qWarning() << "invalid trace json, expected object";
         setError(error, TraceParseError::ParseError::InvalidJSON);
         return {};
     }
 
-    auto jData = jDoc["data"];
-    if (!jData.isArray()) {
-        qWarning() << "invalid trace json, data expected array";
-        setError(error, TraceParseError::ParseError::InvalidJSON);
+    auto tr = readTrace(reader, *source, error);
+    if (!reader.atEnd()) {
+        invalidJson(reader, error);
         return {};
     }
 
-    auto traces = jData.toArray();
-    if (traces.isEmpty()) {
-        return {};
+    if (!tr.isEmpty()) {
+        tr.source = source;
     }
 
-    TraceDocument doc;
+    return tr;
+}
+
+TraceDocument TraceDocument::parseDocument(const QByteArray &data, TraceParseError *error) noexcept
+{
+    return parseDocument(Source::fromData(data), error);
+}
 
-    doc.traces.reserve(traces.size());
+TraceDocument TraceDocument::parseDocument(const QByteArray &data,
+                                           TraceParseError *error,
+                                           int threadCount) noexcept
+{
+    return parseDocument(Source::fromData(data), error, threadCount);
+}
 
-    for (auto jTrace : traces) {
-        if (!jTrace.isObject()) {
-            qWarning() << "invalid trace json, data expected array of objects";
-            setError(error, TraceParseError::ParseError::InvalidJSON);
+TraceDocument TraceDocument::parseDocument(const SourcePtr &source,
+                                           TraceParseError *error,
+                                           int threadCount) noexcept
+{
+    if (threadCount <= 1) {
+        auto reader = makeReader(source->data());
+
+        TraceDocument doc;
+        const bool ok = readDocument(reader, error, [&doc, &source, error](JsonReader &r) {
+            r.beginObject();
+            auto tr = readTrace(r, *source, error);
+            if (!tr.isEmpty()) {
+                tr.source = source;
+            }
+            doc.traces.emplaceBack(std::move(tr));
+        });
+
+        if (!ok) {
             return {};
         }
 
-        auto trace = parseTrace(jTrace.toObject(), error);
-        doc.traces.emplaceBack(trace);
+        return doc;
+    }
+
+    TraceParseError splitError;
+    const auto rawTraces = split(source->data(), &splitError);
+    if (splitError.error != TraceParseError::ParseError::NoError) {
+        setError(error, splitError.error);
+        return {};
+    }
+
+    TraceDocument doc;
+    doc.traces.resize(rawTraces.size());
+    QVector<TraceParseError> errors(rawTraces.size());
+
+    auto traces = doc.traces.data();
+    auto traceErrors = errors.data();
+    parallelFor(rawTraces.size(), threadCount, [&](qsizetype i) {
+        traces[i] = Trace::parse(source, rawTraces[i], &traceErrors[i]);
+    });
+
+    for (const auto &err : errors) {
+        if (err.error != TraceParseError::ParseError::NoError) {
+            setError(error, err.error);
+            break;
+        }
     }
 
     return doc;
 }
 
+QVector<QByteArrayView> TraceDocument::split(QByteArrayView data, TraceParseError *error) noexcept
+{
+    auto reader = makeReader(data);
+
+    QVector<QByteArrayView> traces;
+    const bool ok = readDocument(reader, error, [&traces, &data](JsonReader &r) {
+        const auto begin = r.offset();
+        r.skipValue();
+        traces.emplaceBack(data.data() + begin, static_cast<qsizetype>(r.offset() - begin));
+    });
+
+    if (!ok) {
+        return {};
+    }
+
+    return traces;
+}
+
 QString TraceParseError::errorString() const
 {
     switch (error) {
@@ -264,4 +747,4 @@ QString TraceParseError::errorString() const
     return QString();
 }
 
-} // namespace trace
\ No newline at end of file
+} // namespace trace
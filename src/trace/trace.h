@@ -1,16 +1,29 @@
 #pragma once
 
+#include <QtCore/QByteArrayView>
+
 #include "process.h"
+#include "source.h"
 #include "span.h"
 
 namespace trace {
+
+struct TraceParseError;
+
 struct Trace
 {
-    QString traceID;
+    TraceID traceID;
     QVector<Span> spans;
-    QHash<QString, Process> process;
+    QHash<StringRef, Process> process;
+    //! owns the bytes that strings of the trace point to
+    SourcePtr source;
 
     bool isEmpty() const noexcept;
+
+    //! parse one element of the document 'data' array, data must lie inside source
+    static Trace parse(const SourcePtr &source,
+                       QByteArrayView data,
+                       TraceParseError *error = nullptr) noexcept;
 };
 
 struct TraceParseError
@@ -31,6 +44,19 @@ struct TraceDocument
 
     static TraceDocument parseDocument(const QByteArray &data,
                                        TraceParseError *error = nullptr) noexcept;
+
+    //! traces are parsed on threadCount workers, order of traces is kept
+    static TraceDocument parseDocument(const QByteArray &data,
+                                       TraceParseError *error,
+                                       int threadCount) noexcept;
+
+    static TraceDocument parseDocument(const SourcePtr &source,
+                                       TraceParseError *error = nullptr,
+                                       int threadCount = 1) noexcept;
+
+    //! raw elements of the 'data' array, each one can be passed to Trace::parse
+    static QVector<QByteArrayView> split(QByteArrayView data,
+                                         TraceParseError *error = nullptr) noexcept;
 };
 
 } // namespace trace
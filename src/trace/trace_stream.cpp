@@ -0,0 +1,166 @@
+#include <QtCore/QDebug>
+
+#include "trace.h"
+#include "trace_stream.h"
+
+namespace {
+
+bool isSpace(char c) noexcept
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+} // namespace
+
+namespace trace {
+
+QVector<QByteArray> TraceStream::append(QByteArrayView chunk)
+{
+    QVector<QByteArray> traces;
+    if (m_error) {
+        return traces;
+    }
+
+    const auto *data = chunk.data();
+    const auto size = chunk.size();
+    qsizetype elementBegin = 0;
+
+    for (qsizetype i = 0; i < size; ++i) {
+        const char c = data[i];
+
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_inString = false;
+                m_readingKey = false;
+                continue;
+            }
+
+            // "data" is the only key we look for, longer keys can't match
+            if (m_readingKey && m_key.size() < 8) {
+                m_key += c;
+            }
+            continue;
+        }
+
+        if (isSpace(c)) {
+            continue;
+        }
+
+        if (m_done) {
+            setError("unexpected data after value");
+            return traces;
+        }
+
+        const auto depth = m_stack.size();
+        const bool topLevel = depth == 1;
+
+        if (c == '}' || c == ']') {
+            if (depth == 0 || m_stack.back() != (c == '}' ? '{' : '[')) {
+                setError("unbalanced brackets");
+                return traces;
+            }
+
+            m_stack.pop_back();
+            if (m_inElement && m_stack.size() == 2) {
+                m_element.append(data + elementBegin, i + 1 - elementBegin);
+                traces.push_back(std::move(m_element));
+                m_element = QByteArray();
+                m_inElement = false;
+            } else if (m_inData && m_stack.size() == 1) {
+                m_inData = false;
+            } else if (m_stack.empty()) {
+                m_done = true;
+            }
+            continue;
+        }
+
+        if (topLevel && c == ':') {
+            m_expectKey = false;
+            m_dataValue = !m_hasData && m_key == "data";
+            continue;
+        }
+
+        if (topLevel && c == ',') {
+            m_expectKey = true;
+            continue;
+        }
+
+        if (depth == 0 && c != '{') {
+            setError("expected object");
+            return traces;
+        }
+
+        if (topLevel && m_expectKey && c == '"') {
+            m_inString = true;
+            m_readingKey = true;
+            m_key.clear();
+            continue;
+        }
+
+        if (topLevel && m_dataValue) {
+            m_dataValue = false;
+            if (c != '[') {
+                setError("data expected array");
+                return traces;
+            }
+
+            m_hasData = true;
+            m_inData = true;
+        }
+
+        if (m_inData && depth == 2 && !m_inElement) {
+            if (c == ',') {
+                continue;
+            }
+            if (c != '{') {
+                setError("data expected array of objects");
+                return traces;
+            }
+
+            m_inElement = true;
+            elementBegin = i;
+        }
+
+        if (c == '{' || c == '[') {
+            m_stack.push_back(c);
+            if (m_stack.size() == 1) {
+                m_expectKey = true;
+            }
+        } else if (c == '"') {
+            m_inString = true;
+        }
+    }
+
+    if (m_inElement) {
+        m_element.append(data + elementBegin, size - elementBegin);
+    }
+
+    return traces;
+}
+
+bool TraceStream::finish(TraceParseError *error) const
+{
+    if (m_error || !m_done || !m_hasData) {
+        if (!m_error) {
+            qWarning() << "invalid trace json, incomplete search result";
+        }
+        if (error != nullptr) {
+            error->error = TraceParseError::ParseError::InvalidJSON;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void TraceStream::setError(const char *message)
+{
+    qWarning() << "invalid trace json," << message;
+    m_error = true;
+}
+
+} // namespace trace
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
+#include <QtCore/QVector>
+
+namespace trace {
+
+struct TraceParseError;
+
+/*!
+ * Resumable splitter of a search result that arrives in chunks.
+ *
+ * Chunks are fed as they come and every element of the 'data' array is
+ * returned as soon as its closing brace arrives, ready for Trace::parse.
+ * Only strings and brackets are tracked here: elements are validated when
+ * they are parsed, the rest of the document only has to be balanced.
+ */
+class TraceStream
+{
+public:
+    //! raw traces completed by the chunk, in document order
+    QVector<QByteArray> append(QByteArrayView chunk);
+
+    //! the whole document was fed, false when it is not a complete search result
+    bool finish(TraceParseError *error = nullptr) const;
+
+    bool hasError() const noexcept { return m_error; }
+
+private:
+    void setError(const char *message);
+
+private:
+    std::string m_stack;
+    std::string m_key;
+    QByteArray m_element;
+
+    bool m_inString = false;
+    bool m_escape = false;
+    bool m_readingKey = false;
+    bool m_expectKey = false;
+    bool m_dataValue = false;
+    bool m_hasData = false;
+    bool m_inData = false;
+    bool m_inElement = false;
+    bool m_done = false;
+    bool m_error = false;
+};
+
+} // namespace trace
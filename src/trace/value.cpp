@@ -0,0 +1,182 @@
+#include <cstring>
+
+#include <QtCore/QLocale>
+
+#include "value.h"
+
+static_assert(sizeof(trace::Value) == 16, "Value should stay two words");
+
+namespace trace {
+
+Value Value::fromBool(bool value) noexcept
+{
+    Value v;
+    v.m_type = Type::Bool;
+    v.m_boolean = value;
+    return v;
+}
+
+Value Value::fromInt64(qint64 value) noexcept
+{
+    Value v;
+    v.m_type = Type::Int64;
+    v.m_integer = value;
+    return v;
+}
+
+Value Value::fromDouble(double value) noexcept
+{
+    Value v;
+    v.m_type = Type::Float64;
+    v.m_number = value;
+    return v;
+}
+
+Value Value::fromView(QByteArrayView utf8, Type type) noexcept
+{
+    Value v;
+    v.m_type = type;
+    v.m_size = static_cast<quint32>(utf8.size());
+    if (v.m_size <= InlineCapacity) {
+        if (v.m_size != 0) {
+            std::memcpy(v.m_inline, utf8.data(), v.m_size);
+        }
+    } else {
+        v.m_storage = Storage::View;
+        v.m_chars = utf8.data();
+    }
+    return v;
+}
+
+Value Value::fromView(const StringRef &utf8, Type type) noexcept
+{
+    return fromView(utf8.utf8(), type);
+}
+
+Value Value::fromUtf8(QByteArrayView utf8, Type type)
+{
+    if (utf8.size() <= qsizetype(InlineCapacity)) {
+        return fromView(utf8, type);
+    }
+
+    Value v;
+    v.m_type = type;
+    v.m_storage = Storage::Symbol;
+    v.m_symbol = Symbol::intern(std::string_view(utf8.data(), static_cast<size_t>(utf8.size())));
+    v.m_size = static_cast<quint32>(utf8.size());
+    return v;
+}
+
+Value Value::fromString(const QString &str)
+{
+    return fromUtf8(str.toUtf8());
+}
+
+bool Value::toBool() const noexcept
+{
+    switch (m_type) {
+    case Type::Bool:
+        return m_boolean;
+    case Type::Int64:
+        return m_integer != 0;
+    case Type::Float64:
+        return m_number != 0;
+    case Type::String:
+        return utf8() == "true";
+    default:
+        return false;
+    }
+}
+
+qint64 Value::toInt64() const noexcept
+{
+    switch (m_type) {
+    case Type::Bool:
+        return m_boolean ? 1 : 0;
+    case Type::Int64:
+        return m_integer;
+    case Type::Float64:
+        return static_cast<qint64>(m_number);
+    default:
+        return 0;
+    }
+}
+
+double Value::toDouble() const noexcept
+{
+    switch (m_type) {
+    case Type::Bool:
+        return m_boolean ? 1 : 0;
+    case Type::Int64:
+        return static_cast<double>(m_integer);
+    case Type::Float64:
+        return m_number;
+    default:
+        return 0;
+    }
+}
+
+QByteArrayView Value::utf8() const noexcept
+{
+    if (!isString()) {
+        return {};
+    }
+
+    switch (m_storage) {
+    case Storage::Inline:
+        return QByteArrayView(m_inline, m_size);
+    case Storage::View:
+        return QByteArrayView(m_chars, m_size);
+    case Storage::Symbol:
+        return m_symbol.utf8();
+    }
+
+    return {};
+}
+
+QString Value::toString() const
+{
+    switch (m_type) {
+    case Type::Null:
+        return {};
+    case Type::String:
+    case Type::Binary:
+        if (m_storage == Storage::Symbol) {
+            return m_symbol.toString();
+        }
+        return QString::fromUtf8(utf8());
+    case Type::Bool:
+        return m_boolean ? QStringLiteral("true") : QStringLiteral("false");
+    case Type::Int64:
+        return QString::number(m_integer);
+    case Type::Float64:
+        return QString::number(m_number, 'g', QLocale::FloatingPointShortest);
+    }
+
+    return {};
+}
+
+bool operator==(const Value &a, const Value &b) noexcept
+{
+    if (a.m_type != b.m_type) {
+        return false;
+    }
+
+    switch (a.m_type) {
+    case Value::Type::Null:
+        return true;
+    case Value::Type::Bool:
+        return a.m_boolean == b.m_boolean;
+    case Value::Type::Int64:
+        return a.m_integer == b.m_integer;
+    case Value::Type::Float64:
+        return a.m_number == b.m_number;
+    case Value::Type::String:
+    case Value::Type::Binary:
+        return a.utf8() == b.utf8();
+    }
+
+    return false;
+}
+
+} // namespace trace
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QtCore/QByteArrayView>
+#include <QtCore/QMetaType>
+#include <QtCore/QString>
+
+#include "string_ref.h"
+#include "symbol.h"
+
+namespace trace {
+
+/*!
+ * Value of a tag or a log field, 16 bytes without heap allocations.
+ *
+ * Numbers and booleans are stored inline. Strings of up to InlineCapacity
+ * bytes are copied inline, longer ones are either views into the Source the
+ * trace was parsed from or interned symbols when there is no source. Binary
+ * values keep the base64 text Jaeger sends.
+ */
+class Value
+{
+public:
+    enum class Type : quint8 { Null, String, Bool, Int64, Float64, Binary };
+
+    static constexpr quint32 InlineCapacity = 8;
+
+    Value() = default;
+
+    static Value fromBool(bool value) noexcept;
+    static Value fromInt64(qint64 value) noexcept;
+    static Value fromDouble(double value) noexcept;
+    //! utf8 must stay valid as long as the value, e.g. bytes of a Source
+    static Value fromView(QByteArrayView utf8, Type type = Type::String) noexcept;
+    static Value fromView(const StringRef &utf8, Type type = Type::String) noexcept;
+    //! copy or intern, utf8 may go away after the call
+    static Value fromUtf8(QByteArrayView utf8, Type type = Type::String);
+    static Value fromString(const QString &str);
+
+    Type type() const noexcept { return m_type; }
+    bool isNull() const noexcept { return m_type == Type::Null; }
+    bool isString() const noexcept { return m_type == Type::String || m_type == Type::Binary; }
+
+    bool toBool() const noexcept;
+    qint64 toInt64() const noexcept;
+    double toDouble() const noexcept;
+    //! bytes of a string or binary value, empty for other types
+    QByteArrayView utf8() const noexcept;
+
+    //! display text for any type
+    QString toString() const;
+
+    friend bool operator==(const Value &a, const Value &b) noexcept;
+    friend bool operator!=(const Value &a, const Value &b) noexcept { return !(a == b); }
+
+private:
+    enum class Storage : quint8 { Inline, View, Symbol };
+
+    union {
+        qint64 m_integer = 0;
+        double m_number;
+        bool m_boolean;
+        const char *m_chars;
+        Symbol m_symbol;
+        char m_inline[InlineCapacity];
+    };
+    quint32 m_size = 0;
+    Type m_type = Type::Null;
+    Storage m_storage = Storage::Inline;
+};
+
+} // namespace trace
+
+Q_DECLARE_METATYPE(trace::Value)
@@ -0,0 +1,412 @@
+#include <algorithm>
+
+#include <QtCore/QJsonDocument>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTemporaryDir>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "graph/log_order.h"
+#include "graph/log_search.h"
+#include "graph/snapshot.h"
+#include "graph/trace.h"
+#include "trace/json_reader.h"
+#include "trace/structural_scanner.h"
+#include "trace/trace.h"
+
+namespace {
+
+constexpr int SpansPerTrace = 100;
+constexpr int TreeSpans = 1000000;
+constexpr int SpansPerTree = 100000;
+
+//! span count of the synthetic document, JGV_BENCH_SPANS overrides the default
+int benchmarkSpans()
+{
+    bool ok = false;
+    const int spans = qEnvironmentVariableIntValue("JGV_BENCH_SPANS", &ok);
+    return ok && spans > 0 ? spans : 200000;
+}
+
+QByteArray hex(quint64 value)
+{
+    return QByteArray::number(value, 16).rightJustified(16, '0');
+}
+
+void appendTag(QByteArray &out, const char *key, const QByteArray &value, bool last = false)
+{
+    out += R"({"key": ")";
+    out += key;
+    out += R"(", "type": "string", "value": ")";
+    out += value;
+    out += last ? "\"}" : "\"}, ";
+}
+
+void appendSpan(QByteArray &out, quint64 traceID, quint64 spanID, quint64 parentID, int index)
+{
+    auto *rng = QRandomGenerator::global();
+    const auto start = 1661173878534635 + index * 1000;
+
+    out += R"({"traceID": ")" + hex(traceID) + R"(", "spanID": ")" + hex(spanID) + '"';
+    out += R"(, "flags": 1, "operationName": "HTTP GET /route/)";
+    out += QByteArray::number(index % 16);
+    out += R"(", "references": [)";
+    if (parentID != 0) {
+        out += R"({"refType": "CHILD_OF", "traceID": ")" + hex(traceID);
+        out += R"(", "spanID": ")" + hex(parentID) + R"("})";
+    }
+    out += R"(], "startTime": )" + QByteArray::number(start);
+    out += R"(, "duration": )" + QByteArray::number(rng->bounded(1000, 500000));
+    out += R"(, "tags": [)";
+    appendTag(out, "span.kind", "server");
+    appendTag(out, "http.method", "GET");
+    appendTag(out, "http.url", "/route?pickup=" + QByteArray::number(rng->bounded(1000)));
+    out += R"({"key": "http.status_code", "type": "int64", "value": 200}, )";
+    out += R"({"key": "error", "type": "bool", "value": false}], "logs": [)";
+    for (int i = 0; i < 3; ++i) {
+        out += R"({"timestamp": )" + QByteArray::number(start + i * 10) + R"(, "fields": [)";
+        appendTag(out, "event", "request \\\"" + QByteArray::number(i) + "\\\" handled");
+        appendTag(out, "level", "info", true);
+        out += i == 2 ? "]}" : "]}, ";
+    }
+    out += R"(], "processID": "p)" + QByteArray::number(index % 4) + R"(", "warnings": null})";
+}
+
+//! search result of random traces in jaeger format
+QByteArray makeDocument(int spans)
+{
+    auto *rng = QRandomGenerator::global();
+
+    QByteArray out;
+    out.reserve(qsizetype(spans) * 1300);
+    out += R"({"data": [)";
+
+    for (int first = 0; first < spans; first += SpansPerTrace) {
+        const quint64 traceID = rng->generate64();
+        const int count = std::min(SpansPerTrace, spans - first);
+
+        QVector<quint64> ids(count);
+        for (auto &id : ids) {
+            id = rng->generate64() | 1;
+        }
+
+        if (first != 0) {
+            out += ", ";
+        }
+        out += R"({"traceID": ")" + hex(traceID) + R"(", "spans": [)";
+        for (int i = 0; i < count; ++i) {
+            const auto parent = i == 0 ? 0 : ids[rng->bounded(i)];
+            appendSpan(out, traceID, ids[i], parent, first + i);
+            if (i + 1 != count) {
+                out += ", ";
+            }
+        }
+        out += R"(], "processes": {)";
+        for (int p = 0; p < 4; ++p) {
+            out += R"("p)" + QByteArray::number(p) + R"(": {"serviceName": "service-)";
+            out += QByteArray::number(p) + R"(", "tags": []})";
+            out += p == 3 ? "" : ", ";
+        }
+        out += R"(}, "warnings": null})";
+    }
+
+    out += R"(], "total": 0, "limit": 0, "offset": 0, "errors": null})";
+    return out;
+}
+
+//! visit every value, returns the number of strings seen
+size_t walk(trace::JsonReader &reader)
+{
+    using Token = trace::JsonReader::Token;
+
+    size_t strings = 0;
+    switch (reader.peek()) {
+    case Token::BeginObject: {
+        reader.beginObject();
+        std::string_view key;
+        while (reader.nextKey(&key)) {
+            strings += walk(reader);
+        }
+        break;
+    }
+    case Token::BeginArray:
+        reader.beginArray();
+        while (reader.nextElement()) {
+            strings += walk(reader);
+        }
+        break;
+    case Token::String: {
+        std::string_view value;
+        reader.readString(&value);
+        ++strings;
+        break;
+    }
+    default:
+        reader.skipValue();
+        break;
+    }
+
+    return strings;
+}
+
+//! traces with random span trees built in memory, without json and logs
+trace::TraceDocument makeSpanTrees(int spans, int spansPerTree = SpansPerTree)
+{
+    auto *rng = QRandomGenerator::global();
+    const auto operation = trace::Symbol::intern("HTTP GET /route");
+    const auto kind = trace::Symbol::intern("span.kind");
+    const auto status = trace::Symbol::intern("http.status_code");
+
+    trace::TraceDocument doc;
+    for (int first = 0; first < spans; first += spansPerTree) {
+        trace::Trace tr;
+        tr.traceID = trace::TraceID(0, rng->generate64());
+        const auto processID = trace::StringRef::view("p1");
+        tr.process.insert(processID, trace::Process{trace::Symbol::intern("service"), {}});
+
+        const int count = std::min(spansPerTree, spans - first);
+        tr.spans.resize(count);
+        for (int i = 0; i < count; ++i) {
+            auto &span = tr.spans[i];
+            span.traceID = tr.traceID;
+            span.spanID = trace::SpanID(quint64(first + i) + 1);
+            span.operationName = operation;
+            span.startTime = trace::TimePoint(std::chrono::microseconds(1661173878534635 + i));
+            span.duration = std::chrono::microseconds(rng->bounded(1000, 500000));
+            span.processID = processID;
+            span.tags = {{kind, trace::Value::fromView(QByteArrayView("server"))},
+                         {status, trace::Value::fromInt64(200)}};
+            if (i != 0) {
+                const auto parent = tr.spans[rng->bounded(i)].spanID;
+                span.references.push_back(
+                    {trace::SpanReference::Type::ChildOf, tr.traceID, parent});
+            }
+        }
+
+        doc.traces.push_back(std::move(tr));
+    }
+
+    return doc;
+}
+
+//! depth first over children of every root, returns the sum of durations
+qint64 traverse(const graph::TraceGraph &traceGraph)
+{
+    qint64 total = 0;
+    std::vector<const graph::Span *> stack;
+    for (const auto &tr : traceGraph.traces) {
+        stack.push_back(tr->root);
+        while (!stack.empty()) {
+            const auto *span = stack.back();
+            stack.pop_back();
+            total += span->duration.count();
+            stack.insert(stack.end(), span->children.begin(), span->children.end());
+        }
+    }
+
+    return total;
+}
+
+const QByteArray &document()
+{
+    static const QByteArray data = makeDocument(benchmarkSpans());
+    return data;
+}
+
+} // namespace
+
+using namespace trace;
+
+TEST_CASE("parse large document", "[benchmark]")
+{
+    const auto &data = document();
+    const std::string_view view(data.constData(), static_cast<size_t>(data.size()));
+
+    WARN("document size " << data.size() / (1024 * 1024) << " MB");
+
+    BENCHMARK("QJsonDocument")
+    {
+        return QJsonDocument::fromJson(data).isObject();
+    };
+
+    BENCHMARK("JsonReader")
+    {
+        JsonReader reader(view);
+        return walk(reader);
+    };
+
+    BENCHMARK("JsonReader with structural index")
+    {
+        JsonReader reader(view, StructuralScanner::bestImplementation());
+        return walk(reader);
+    };
+
+    BENCHMARK("StructuralScanner")
+    {
+        StructuralScanner scanner(view);
+        std::vector<uint64_t> positions;
+        size_t count = 0;
+        while (scanner.scan(positions)) {
+            count += positions.size();
+        }
+        return count;
+    };
+
+    BENCHMARK("TraceDocument")
+    {
+        return TraceDocument::parseDocument(data).traces.size();
+    };
+}
+
+TEST_CASE("reload snapshot", "[benchmark]")
+{
+    const auto traceGraph = graph::TraceGraph::parseGraph(document(), nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("benchmark.jgv");
+    REQUIRE(graph::Snapshot::save(*traceGraph, fileName));
+
+    BENCHMARK("TraceGraph::parseGraph")
+    {
+        return graph::TraceGraph::parseGraph(document(), nullptr, 1)->traces.size();
+    };
+
+    BENCHMARK("LogRecord::decodeFields of every log")
+    {
+        const auto keeper = trace::Source::fromData(QByteArray());
+        qsizetype fieldCount = 0;
+        for (const auto &tr : traceGraph->traces) {
+            for (const auto &log : tr->logs) {
+                fieldCount += log.decodeFields(*keeper).size();
+            }
+        }
+        return fieldCount;
+    };
+
+    BENCHMARK("Snapshot::load")
+    {
+        return graph::Snapshot::load(fileName)->traces.size();
+    };
+}
+
+TEST_CASE("order logs", "[benchmark]")
+{
+    const auto traceGraph = graph::TraceGraph::parseGraph(document(), nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    BENCHMARK("std::sort through spans")
+    {
+        std::vector<graph::LogRef> order;
+        for (const auto &tr : traceGraph->traces) {
+            for (auto &span : tr->spans) {
+                for (quint32 k = 0; k < span.logs.size(); ++k) {
+                    order.push_back({&span, k});
+                }
+            }
+        }
+        std::sort(order.begin(), order.end(), [](const auto &a, const auto &b) {
+            return a.record().timestamp < b.record().timestamp;
+        });
+        return order.size();
+    };
+
+    BENCHMARK("orderLogs")
+    {
+        return graph::orderLogs(*traceGraph, 1).size();
+    };
+
+    BENCHMARK("orderLogs on 4 threads")
+    {
+        return graph::orderLogs(*traceGraph, 4).size();
+    };
+}
+
+TEST_CASE("search logs", "[benchmark]")
+{
+    const auto traceGraph = graph::TraceGraph::parseGraph(document(), nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+    const auto logs = graph::orderLogs(*traceGraph, 1);
+    const auto index = graph::LogSearchIndex::build(logs, 4);
+    const graph::LogSearchIndex scan;
+
+    // every span has three logs, the second one of each matches
+    const QByteArray query = R"(request "1" handled)";
+    REQUIRE(index.search(logs, query).size() == logs.size() / 3);
+    REQUIRE(scan.search(logs, query).size() == logs.size() / 3);
+
+    BENCHMARK("build index on 4 threads")
+    {
+        return graph::LogSearchIndex::build(logs, 4).isEmpty();
+    };
+
+    BENCHMARK("scan")
+    {
+        return scan.search(logs, query).size();
+    };
+
+    BENCHMARK("index")
+    {
+        return index.search(logs, query).size();
+    };
+}
+
+TEST_CASE("span trees", "[benchmark]")
+{
+    const auto doc = makeSpanTrees(TreeSpans);
+    const auto traceGraph = graph::TraceGraph::makeGraph(doc, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    BENCHMARK("traverse 1M spans")
+    {
+        return traverse(*traceGraph);
+    };
+
+    BENCHMARK_ADVANCED("release 1M spans")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<std::shared_ptr<graph::TraceGraph>> graphs(meter.runs());
+        for (auto &g : graphs) {
+            g = graph::TraceGraph::makeGraph(doc, 1);
+        }
+
+        meter.measure([&graphs](int i) { graphs[i].reset(); });
+    };
+}
+
+TEST_CASE("time window queries", "[benchmark]")
+{
+    const auto traceGraph = graph::TraceGraph::makeGraph(makeSpanTrees(TreeSpans, TreeSpans), 1);
+    REQUIRE(traceGraph != nullptr);
+
+    auto &tr = *traceGraph->traces.front();
+    const auto begin = tr.root->startTime;
+
+    BENCHMARK("build interval index of 1M spans")
+    {
+        return graph::IntervalIndex(tr).size();
+    };
+
+    const auto &index = tr.intervals();
+    auto *rng = QRandomGenerator::global();
+
+    BENCHMARK("count spans in 1000 windows")
+    {
+        size_t total = 0;
+        for (int i = 0; i < 1000; ++i) {
+            const auto from = begin + std::chrono::microseconds(rng->bounded(TreeSpans));
+            total += index.count(from, from + std::chrono::microseconds(100));
+        }
+        return total;
+    };
+
+    BENCHMARK("query spans in 100 windows")
+    {
+        size_t total = 0;
+        for (int i = 0; i < 100; ++i) {
+            const auto from = begin + std::chrono::microseconds(rng->bounded(TreeSpans));
+            total += index.query(from, from + std::chrono::microseconds(100)).size();
+        }
+        return total;
+    };
+}
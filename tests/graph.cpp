@@ -1,27 +1,35 @@
+#include <algorithm>
+#include <memory>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEventLoop>
 #include <QtCore/QFile>
+#include <QtCore/QSet>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTimer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
 
 #include <catch2/catch_test_macros.hpp>
 
+#include "graph/bitmap.h"
+#include "graph/critical_path.h"
+#include "graph/dependency_graph.h"
+#include "graph/latency.h"
+#include "graph/log_order.h"
+#include "graph/log_search.h"
+#include "graph/snapshot.h"
+#include "graph/span_group.h"
+#include "graph/trace_diff.h"
 #include "graph/trace.h"
 #include "trace/trace.h"
 
-namespace {
-
-QByteArray readAll(const QString &filename)
-{
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCritical() << "file not open" << filename << file.errorString();
-        return {};
-    }
+#include "test_data.h"
 
-    auto data = file.readAll();
-    file.close();
-
-    return data;
-}
-
-} // namespace
+using tests::makeSearchResult;
+using tests::readAll;
 
 TEST_CASE("make trace graph", "[graph]")
 {
@@ -34,32 +42,40 @@ TEST_CASE("make trace graph", "[graph]")
     REQUIRE(error.error == trace::TraceParseError::ParseError::NoError);
     REQUIRE(doc.traces.size() == 1);
 
-    auto traceGraph = graph::TraceGraph::makeGraph(doc);
+    const auto tagCount = doc.traces[0].spans[0].tags.size();
+    auto traceGraph = graph::TraceGraph::makeGraph(std::move(doc));
     REQUIRE(traceGraph != nullptr);
     REQUIRE(traceGraph->traces.size() == 1);
+    REQUIRE(doc.traces.isEmpty());
+    REQUIRE(traceGraph->traces[0]->spans[0].tags.size() == static_cast<size_t>(tagCount));
 
     auto trace = traceGraph->traces.front();
     REQUIRE(trace->root != nullptr);
     REQUIRE_FALSE(trace->root->children.empty());
     REQUIRE(trace->spans.size() == 51);
+    REQUIRE(trace->children.size() == 50);
+
+    // fields stay in the source until they are shown
+    REQUIRE_FALSE(trace->root->logs.empty());
+    REQUIRE(trace->root->logs[0].fields.empty());
+    REQUIRE_FALSE(trace->root->logs[0].rawFields.isEmpty());
 
     int hasNotChildren = 0;
     int hasTimeShift = 0;
     int logWithDefaultLevel = 0;
-    for (int i = 0; i < trace->spans.size(); ++i) {
-        auto span = trace->spans[i].get();
-        if (span != trace->root) {
-            REQUIRE(span->parent != nullptr);
+    for (const auto &span : trace->spans) {
+        if (&span != trace->root) {
+            REQUIRE(span.parent != nullptr);
         }
 
-        if (span->children.empty()) {
+        if (span.children.empty()) {
             ++hasNotChildren;
         }
 
-        if (span->shift.count() > 0) {
+        if (span.shift.count() > 0) {
             ++hasTimeShift;
         }
-        for (const auto &rec : span->logs) {
+        for (const auto &rec : span.logs) {
             if (rec.level == graph::LogRecord::Level::No) {
                 logWithDefaultLevel++;
             }
@@ -69,4 +85,776 @@ TEST_CASE("make trace graph", "[graph]")
     REQUIRE(hasNotChildren == 25);
     REQUIRE(hasTimeShift == 50);
     REQUIRE(logWithDefaultLevel == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("parse trace graphs in parallel", "[graph]")
+{
+    auto data = makeSearchResult(readAll("hotroad_rachel.json"), 8);
+    REQUIRE_FALSE(data.isEmpty());
+
+    trace::TraceParseError error;
+    auto traceGraph = graph::TraceGraph::parseGraph(data, &error, 4);
+
+    REQUIRE(error.error == trace::TraceParseError::ParseError::NoError);
+    REQUIRE(traceGraph != nullptr);
+    REQUIRE(traceGraph->traces.size() == 8);
+    for (size_t i = 0; i < traceGraph->traces.size(); ++i) {
+        const auto &trace = traceGraph->traces[i];
+        REQUIRE(trace->traceID.toString().toULongLong(nullptr, 16) == i);
+        REQUIRE(trace->spans.size() == 51);
+        REQUIRE(trace->root != nullptr);
+        REQUIRE(trace->owns(*trace->root));
+    }
+    REQUIRE_FALSE(traceGraph->traces[0]->owns(*traceGraph->traces[1]->root));
+}
+
+TEST_CASE("make trace graph without a top span", "[graph]")
+{
+    // a partial trace, the top span references a parent that was not fetched
+    const QByteArray data = R"({"data": [{"traceID": "1", "spans": [
+        {"traceID": "1", "spanID": "2", "operationName": "a", "startTime": 10, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "3", "operationName": "b", "startTime": 15, "duration": 10,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "2"}],
+         "processID": "p1"}
+        ], "processes": {"p1": {"serviceName": "s"}}}]})";
+
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    const auto &tr = *traceGraph->traces.front();
+    REQUIRE(tr.root == &tr.spans[0]);
+    REQUIRE(tr.spans[1].parent == tr.root);
+    REQUIRE(tr.spans[1].shift == std::chrono::microseconds(5));
+}
+
+TEST_CASE("save and load snapshot", "[graph]")
+{
+    auto data = makeSearchResult(readAll("hotroad_rachel.json"), 4);
+    REQUIRE_FALSE(data.isEmpty());
+
+    trace::TraceParseError parseError;
+    auto expected = graph::TraceGraph::parseGraph(data, &parseError, 1);
+    REQUIRE(expected != nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const auto fileName = dir.filePath("trace.jgv");
+
+    graph::SnapshotError error;
+    REQUIRE(graph::Snapshot::save(*expected, fileName, &error));
+
+    auto actual = graph::Snapshot::load(fileName, &error, 2);
+    REQUIRE(error.error == graph::SnapshotError::Error::NoError);
+    REQUIRE(actual != nullptr);
+    REQUIRE(actual->traces.size() == expected->traces.size());
+
+    const auto keeper = trace::Source::fromData(QByteArray());
+    for (size_t t = 0; t < expected->traces.size(); ++t) {
+        const auto &a = *actual->traces[t];
+        const auto &e = *expected->traces[t];
+        REQUIRE(a.traceID == e.traceID);
+        REQUIRE(a.traceID.toString() == e.traceID.toString());
+        REQUIRE(a.source->isMapped());
+        REQUIRE(a.spans.size() == e.spans.size());
+        REQUIRE(a.process.size() == e.process.size());
+        REQUIRE(a.root - a.spans.data() == e.root - e.spans.data());
+
+        for (size_t i = 0; i < e.spans.size(); ++i) {
+            const auto &as = a.spans[i];
+            const auto &es = e.spans[i];
+            REQUIRE(as.spanID == es.spanID);
+            REQUIRE(as.operationName == es.operationName);
+            REQUIRE(as.startTime == es.startTime);
+            REQUIRE(as.duration == es.duration);
+            REQUIRE(as.shift == es.shift);
+            REQUIRE(as.selfTime == es.selfTime);
+            REQUIRE(as.depth == es.depth);
+            REQUIRE(as.descendantCount == es.descendantCount);
+            REQUIRE(as.enter == es.enter);
+            REQUIRE(as.exit == es.exit);
+            REQUIRE(as.shapeHash == es.shapeHash);
+            REQUIRE(as.subtreeHasError == es.subtreeHasError);
+            REQUIRE(as.process->name == es.process->name);
+            REQUIRE(as.children.size() == es.children.size());
+            REQUIRE((as.parent == nullptr) == (es.parent == nullptr));
+            if (es.parent != nullptr) {
+                REQUIRE(as.parent->spanID == es.parent->spanID);
+            }
+
+            REQUIRE(as.tags.size() == es.tags.size());
+            for (size_t j = 0; j < es.tags.size(); ++j) {
+                REQUIRE(as.tags[j].key == es.tags[j].key);
+                REQUIRE(as.tags[j].value.toString() == es.tags[j].value.toString());
+            }
+
+            REQUIRE(as.logs.size() == es.logs.size());
+            for (size_t j = 0; j < es.logs.size(); ++j) {
+                REQUIRE(as.logs[j].timestamp == es.logs[j].timestamp);
+                REQUIRE(as.logs[j].level == es.logs[j].level);
+                REQUIRE(as.logs[j].hasError == es.logs[j].hasError);
+                REQUIRE(as.logs[j].decodeFields(*keeper).size()
+                        == es.logs[j].decodeFields(*keeper).size());
+            }
+        }
+    }
+
+    // flip one byte of the payload
+    QFile file(fileName);
+    REQUIRE(file.open(QIODevice::ReadWrite));
+    file.seek(file.size() / 2);
+    char c = 0;
+    file.getChar(&c);
+    file.seek(file.size() / 2);
+    file.putChar(static_cast<char>(c ^ 0x20));
+    file.close();
+
+    REQUIRE(graph::Snapshot::load(fileName, &error) == nullptr);
+    REQUIRE(error.error == graph::SnapshotError::Error::ChecksumMismatch);
+
+    REQUIRE_FALSE(graph::Snapshot::isSnapshot(data));
+}
+
+TEST_CASE("build trace graph from chunks", "[graph]")
+{
+    const auto data = makeSearchResult(readAll("hotroad_rachel.json"), 4);
+    REQUIRE_FALSE(data.isEmpty());
+
+    const auto expected = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    REQUIRE(expected != nullptr);
+
+    for (const qsizetype chunkSize : {1, 7, 4096, 1 << 20}) {
+        for (const int threadCount : {1, 4}) {
+            graph::TraceGraphBuilder builder(threadCount);
+            for (qsizetype i = 0; i < data.size(); i += chunkSize) {
+                const auto size = std::min(chunkSize, data.size() - i);
+                builder.append(QByteArrayView(data).sliced(i, size));
+            }
+
+            trace::TraceParseError error;
+            const auto actual = builder.finish(&error);
+            REQUIRE(error.error == trace::TraceParseError::ParseError::NoError);
+            REQUIRE(actual != nullptr);
+            REQUIRE(actual->traces.size() == expected->traces.size());
+            for (size_t t = 0; t < expected->traces.size(); ++t) {
+                REQUIRE(actual->traces[t]->traceID == expected->traces[t]->traceID);
+                REQUIRE(actual->traces[t]->spans.size() == expected->traces[t]->spans.size());
+                REQUIRE(actual->traces[t]->root->spanID == expected->traces[t]->root->spanID);
+            }
+        }
+    }
+
+    graph::TraceGraphBuilder truncated;
+    truncated.append(QByteArrayView(data).first(data.size() / 2));
+    trace::TraceParseError error;
+    REQUIRE(truncated.finish(&error) == nullptr);
+    REQUIRE(error.error == trace::TraceParseError::ParseError::InvalidJSON);
+}
+
+TEST_CASE("build trace graph while downloading", "[graph]")
+{
+    char name[] = "graph_tests";
+    char *argv[] = {name, nullptr};
+    int argc = 1;
+    QCoreApplication app(argc, argv);
+
+    const auto data = makeSearchResult(readAll("hotroad_rachel.json"), 8);
+    REQUIRE_FALSE(data.isEmpty());
+
+    // stand-in for jaeger query, the body goes out in chunks on timer ticks
+    QTcpServer server;
+    REQUIRE(server.listen(QHostAddress::LocalHost));
+    QObject::connect(&server, &QTcpServer::newConnection, [&server, &data]() {
+        auto *socket = server.nextPendingConnection();
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [socket, &data]() {
+            if (!socket->readAll().endsWith("\r\n\r\n")) {
+                return;
+            }
+
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                          "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n");
+
+            auto *timer = new QTimer(socket);
+            auto offset = std::make_shared<qsizetype>(0);
+            QObject::connect(timer, &QTimer::timeout, socket, [socket, timer, offset, &data]() {
+                const auto chunk = data.mid(*offset, 32 * 1024);
+                *offset += chunk.size();
+                socket->write(QByteArray::number(chunk.size(), 16) + "\r\n" + chunk + "\r\n");
+                if (chunk.isEmpty()) {
+                    timer->stop();
+                    socket->disconnectFromHost();
+                }
+            });
+            timer->start(1);
+        });
+    });
+
+    QNetworkAccessManager manager;
+    const QUrl url(QString("http://127.0.0.1:%1/api/traces").arg(server.serverPort()));
+    auto *reply = manager.get(QNetworkRequest(url));
+
+    graph::TraceGraphBuilder builder(4);
+    int chunks = 0;
+    QObject::connect(reply, &QNetworkReply::readyRead, [reply, &builder, &chunks]() {
+        builder.append(reply->readAll());
+        ++chunks;
+    });
+
+    QEventLoop loop;
+    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    REQUIRE(reply->isFinished());
+    REQUIRE(reply->error() == QNetworkReply::NoError);
+    builder.append(reply->readAll());
+    delete reply;
+
+    trace::TraceParseError error;
+    const auto traceGraph = builder.finish(&error);
+    REQUIRE(error.error == trace::TraceParseError::ParseError::NoError);
+    REQUIRE(traceGraph != nullptr);
+    REQUIRE(traceGraph->traces.size() == 8);
+    REQUIRE(chunks > 1);
+}
+
+TEST_CASE("compute critical path", "[graph]")
+{
+    // root 0..100, 'a' 10..40 and 'b' 50..90 run in turn, 'c' 20..30 overlaps 'a' inside root
+    // and 'd' 35..80 is a child of 'a' that ends after it
+    const QByteArray data = R"({"data": [{"traceID": "1", "spans": [
+        {"traceID": "1", "spanID": "1", "operationName": "root", "references": [],
+         "startTime": 0, "duration": 100, "processID": "p1"},
+        {"traceID": "1", "spanID": "2", "operationName": "a", "startTime": 10, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "3", "operationName": "b", "startTime": 50, "duration": 40,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "4", "operationName": "c", "startTime": 20, "duration": 10,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "5", "operationName": "d", "startTime": 35, "duration": 45,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "2"}],
+         "processID": "p1"}
+        ], "processes": {"p1": {"serviceName": "s"}}}]})";
+
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    const auto &tr = *traceGraph->traces.front();
+    const auto path = graph::CriticalPath::compute(tr);
+
+    using us = std::chrono::microseconds;
+    const std::vector<us> contribution = {us(30), us(25), us(40), us(0), us(5)};
+    REQUIRE(path.contribution == contribution);
+    REQUIRE(path.sections.size() == 6);
+    REQUIRE(path.sections.front().span == tr.root);
+    REQUIRE(path.sections[1].span->operationName == trace::Symbol::intern("a"));
+    REQUIRE(path.sections[2].span->operationName == trace::Symbol::intern("d"));
+    // 'd' is clamped to the end of 'a'
+    REQUIRE(path.sections[2].end == tr.spans[1].startTime + tr.spans[1].duration);
+
+    const auto sample = graph::TraceGraph::parseGraph(readAll("hotroad_rachel.json"), nullptr, 1);
+    REQUIRE(sample != nullptr);
+
+    const auto &root = *sample->traces.front()->root;
+    const auto samplePath = graph::CriticalPath::compute(*sample->traces.front());
+    REQUIRE(samplePath.sections.front().start == root.startTime);
+    REQUIRE(samplePath.sections.back().end == root.startTime + root.duration);
+
+    us total(0);
+    for (size_t i = 0; i < samplePath.sections.size(); ++i) {
+        const auto &section = samplePath.sections[i];
+        total += section.end - section.start;
+        if (i != 0) {
+            REQUIRE(samplePath.sections[i - 1].end == section.start);
+        }
+    }
+    REQUIRE(total == root.duration);
+
+    REQUIRE(graph::CriticalPath::compute(graph::Trace()).isEmpty());
+}
+
+TEST_CASE("derive span metrics", "[graph]")
+{
+    // 'a' 10..40 and 'b' 30..60 overlap inside root, 'c' is a child of 'a' with an error log
+    const QByteArray data = R"({"data": [{"traceID": "1", "spans": [
+        {"traceID": "1", "spanID": "1", "operationName": "root", "references": [],
+         "startTime": 0, "duration": 100, "processID": "p1"},
+        {"traceID": "1", "spanID": "2", "operationName": "a", "startTime": 10, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "3", "operationName": "b", "startTime": 30, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "tags": [{"key": "error", "type": "bool", "value": true}], "processID": "p1"},
+        {"traceID": "1", "spanID": "4", "operationName": "c", "startTime": 15, "duration": 10,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "2"}],
+         "logs": [{"timestamp": 20, "fields": [{"key": "error", "type": "string",
+                                               "value": "timeout"}]}],
+         "processID": "p1"}
+        ], "processes": {"p1": {"serviceName": "s"}}}]})";
+
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    const auto &spans = traceGraph->traces.front()->spans;
+    using us = std::chrono::microseconds;
+    REQUIRE(spans[0].selfTime == us(50));
+    REQUIRE(spans[1].selfTime == us(20));
+    REQUIRE(spans[3].selfTime == us(10));
+    REQUIRE(spans[3].depth == 2);
+    REQUIRE(spans[0].descendantCount == 3);
+    REQUIRE(spans[1].descendantCount == 1);
+
+    REQUIRE(spans[0].enter == 0);
+    REQUIRE(spans[0].exit == 4);
+    REQUIRE(spans[1].exit == spans[1].enter + 2);
+    REQUIRE(spans[0].contains(spans[3]));
+    REQUIRE(spans[1].contains(spans[3]));
+    REQUIRE(spans[1].contains(spans[1]));
+    REQUIRE_FALSE(spans[2].contains(spans[3]));
+    REQUIRE_FALSE(spans[3].contains(spans[1]));
+
+    REQUIRE(spans[2].hasError);
+    REQUIRE(spans[0].subtreeHasError);
+    // error logs count as soon as the graph is built
+    REQUIRE(spans[3].hasError);
+    REQUIRE(spans[1].subtreeHasError);
+    REQUIRE_FALSE(spans[1].hasError);
+}
+
+TEST_CASE("aggregate latency histograms", "[graph]")
+{
+    using us = std::chrono::microseconds;
+
+    graph::LatencyHistogram histogram;
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.record(us(i * 100));
+    }
+    REQUIRE(histogram.count() == 1000);
+    REQUIRE(histogram.min() == us(100));
+    REQUIRE(histogram.max() == us(100000));
+    // buckets are within 1/64 of the value
+    REQUIRE(histogram.percentile(0.5) >= us(50000));
+    REQUIRE(histogram.percentile(0.5) <= us(50000 + 50000 / 64));
+    REQUIRE(histogram.percentile(0.99) >= us(99000));
+    REQUIRE(histogram.percentile(0.99) <= us(99000 + 99000 / 64));
+    REQUIRE(histogram.percentile(1) == us(100000));
+
+    graph::LatencyHistogram low;
+    graph::LatencyHistogram high;
+    for (int i = 1; i <= 1000; ++i) {
+        (i <= 500 ? low : high).record(us(i * 100));
+    }
+    high.merge(low);
+    REQUIRE(high.count() == histogram.count());
+    REQUIRE(high.min() == histogram.min());
+    for (const double q : {0.0, 0.25, 0.5, 0.95, 0.99, 1.0}) {
+        REQUIRE(high.percentile(q) == histogram.percentile(q));
+    }
+
+    for (quint64 v : {quint64(0), quint64(127), quint64(128), quint64(1000001)}) {
+        const auto index = graph::LatencyHistogram::bucketIndex(v);
+        REQUIRE(graph::LatencyHistogram::bucketHighest(index) >= v);
+        REQUIRE((index == 0 || graph::LatencyHistogram::bucketHighest(index - 1) < v));
+    }
+
+    const auto data = makeSearchResult(readAll("hotroad_rachel.json"), 8);
+    const auto serial = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    const auto parallel = graph::TraceGraph::parseGraph(data, nullptr, 4);
+    REQUIRE(serial != nullptr);
+    REQUIRE(parallel != nullptr);
+
+    const auto &histograms = parallel->latency.histograms();
+    quint64 spans = 0;
+    for (auto iter = histograms.cbegin(); iter != histograms.cend(); ++iter) {
+        spans += iter.value().count();
+        REQUIRE_FALSE(iter.key().service.isEmpty());
+
+        const auto &expected = serial->latency.histograms()[iter.key()];
+        REQUIRE(iter.value().count() == expected.count());
+        REQUIRE(iter.value().percentile(0.95) == expected.percentile(0.95));
+    }
+    REQUIRE(spans == 8 * 51);
+    REQUIRE(histograms.size() == serial->latency.histograms().size());
+}
+
+TEST_CASE("diff traces", "[graph]")
+{
+    // the right trace keeps 'a', drops 'b' with its child 'c' and adds a second 'a' and 'd'
+    const QByteArray data = R"({"data": [{"traceID": "1", "spans": [
+        {"traceID": "1", "spanID": "1", "operationName": "root", "references": [],
+         "startTime": 0, "duration": 100, "processID": "p1"},
+        {"traceID": "1", "spanID": "2", "operationName": "a", "startTime": 10, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "3", "operationName": "b", "startTime": 50, "duration": 40,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "4", "operationName": "c", "startTime": 60, "duration": 10,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "3"}],
+         "processID": "p1"}
+        ], "processes": {"p1": {"serviceName": "s"}}},
+        {"traceID": "2", "spans": [
+        {"traceID": "2", "spanID": "1", "operationName": "root", "references": [],
+         "startTime": 0, "duration": 120, "processID": "p1"},
+        {"traceID": "2", "spanID": "2", "operationName": "a", "startTime": 10, "duration": 35,
+         "references": [{"refType": "CHILD_OF", "traceID": "2", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "2", "spanID": "3", "operationName": "a", "startTime": 60, "duration": 10,
+         "references": [{"refType": "CHILD_OF", "traceID": "2", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "2", "spanID": "4", "operationName": "d", "startTime": 80, "duration": 5,
+         "references": [{"refType": "CHILD_OF", "traceID": "2", "spanID": "1"}],
+         "processID": "p1"}
+        ], "processes": {"p1": {"serviceName": "s"}}}]})";
+
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+    REQUIRE(traceGraph->traces.size() == 2);
+
+    using Kind = graph::TraceDiff::Node::Kind;
+    using us = std::chrono::microseconds;
+
+    const auto diff = graph::TraceDiff::compute(*traceGraph->traces[0], *traceGraph->traces[1]);
+    REQUIRE(diff.nodes.size() == 5);
+    REQUIRE(diff.addedSpans == 2);
+    REQUIRE(diff.removedSpans == 2);
+
+    REQUIRE(diff.nodes[0].kind == Kind::Matched);
+    REQUIRE(diff.nodes[0].parent == graph::TraceDiff::NoParent);
+    REQUIRE(diff.nodes[0].delta() == us(20));
+
+    REQUIRE(diff.nodes[1].kind == Kind::Matched);
+    REQUIRE(diff.nodes[1].delta() == us(5));
+    REQUIRE(diff.nodes[2].kind == Kind::Removed);
+    REQUIRE(diff.nodes[2].left->operationName == trace::Symbol::intern("b"));
+    REQUIRE(diff.nodes[3].kind == Kind::Added);
+    REQUIRE(diff.nodes[3].right->operationName == trace::Symbol::intern("a"));
+    REQUIRE(diff.nodes[4].kind == Kind::Added);
+    for (size_t i = 1; i < diff.nodes.size(); ++i) {
+        REQUIRE(diff.nodes[i].parent == 0);
+        REQUIRE(diff.nodes[i].depth == 1);
+    }
+
+    const auto sample = graph::TraceGraph::parseGraph(readAll("hotroad_rachel.json"), nullptr, 1);
+    REQUIRE(sample != nullptr);
+
+    const auto &sampleTrace = *sample->traces.front();
+    const auto self = graph::TraceDiff::compute(sampleTrace, sampleTrace);
+    REQUIRE(self.nodes.size() == sampleTrace.spans.size());
+    REQUIRE(self.addedSpans == 0);
+    REQUIRE(self.removedSpans == 0);
+    for (const auto &node : self.nodes) {
+        REQUIRE(node.kind == Kind::Matched);
+        REQUIRE(node.left == node.right);
+    }
+}
+
+TEST_CASE("merge service dependency graph", "[graph]")
+{
+    const auto single = graph::TraceGraph::parseGraph(readAll("hotroad_rachel.json"), nullptr, 1);
+    REQUIRE(single != nullptr);
+
+    QSet<trace::Symbol> names;
+    for (const auto &process : single->traces.front()->process) {
+        names.insert(process.name);
+    }
+
+    const auto one = graph::DependencyGraph::build(*single);
+    REQUIRE(one.services.size() == static_cast<size_t>(names.size()));
+    REQUIRE_FALSE(one.edges.empty());
+
+    const auto data = makeSearchResult(readAll("hotroad_rachel.json"), 8);
+    const auto search = graph::TraceGraph::parseGraph(data, nullptr, 4);
+    REQUIRE(search != nullptr);
+
+    using Grouping = graph::DependencyGraph::Grouping;
+    const auto serial = graph::DependencyGraph::build(*search, Grouping::ByName, 1);
+    const auto sharded = graph::DependencyGraph::build(*search, Grouping::ByName, 4);
+    REQUIRE(sharded.services.size() == one.services.size());
+    REQUIRE(sharded.edges.size() == one.edges.size());
+
+    quint64 spans = 0;
+    for (size_t i = 0; i < sharded.services.size(); ++i) {
+        REQUIRE(sharded.services[i].name == serial.services[i].name);
+        REQUIRE(sharded.services[i].spanCount == 8 * one.services[i].spanCount);
+        spans += sharded.services[i].spanCount;
+    }
+    REQUIRE(spans == 8 * 51);
+
+    for (size_t i = 0; i < sharded.edges.size(); ++i) {
+        const auto &edge = sharded.edges[i];
+        REQUIRE(edge.from == one.edges[i].from);
+        REQUIRE(edge.to == one.edges[i].to);
+        REQUIRE(edge.calls.size() == 8 * one.edges[i].calls.size());
+        REQUIRE(edge.calls.size() == serial.edges[i].calls.size());
+        for (const auto &call : edge.calls) {
+            REQUIRE(sharded.services[edge.to].name == call.span->process->name);
+        }
+    }
+}
+
+TEST_CASE("group services by name and tags", "[graph]")
+{
+    // p1 and p2 have the same tags in another order, p3 differs by a value
+    const QByteArray data = R"({"data": [{"traceID": "1", "spans": [
+        {"traceID": "1", "spanID": "1", "operationName": "root", "references": [],
+         "startTime": 0, "duration": 100, "processID": "p1"},
+        {"traceID": "1", "spanID": "2", "operationName": "a", "startTime": 10, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "3", "operationName": "b", "startTime": 30, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p3"}
+        ], "processes": {
+        "p1": {"serviceName": "s", "tags": [{"key": "host", "type": "string", "value": "a"},
+                                            {"key": "ip", "type": "string", "value": "1"}]},
+        "p2": {"serviceName": "s", "tags": [{"key": "ip", "type": "string", "value": "1"},
+                                            {"key": "host", "type": "string", "value": "a"}]},
+        "p3": {"serviceName": "s", "tags": [{"key": "host", "type": "string", "value": "b"},
+                                            {"key": "ip", "type": "string", "value": "1"}]}
+        }}]})";
+
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    using Grouping = graph::DependencyGraph::Grouping;
+    const auto byName = graph::DependencyGraph::build(*traceGraph, Grouping::ByName);
+    REQUIRE(byName.services.size() == 1);
+    REQUIRE(byName.services[0].spanCount == 3);
+    REQUIRE(byName.edges.empty());
+
+    const auto byTags = graph::DependencyGraph::build(*traceGraph, Grouping::ByNameAndTags);
+    REQUIRE(byTags.services.size() == 2);
+    REQUIRE(byTags.edges.size() == 1);
+    const auto &edge = byTags.edges.front();
+    REQUIRE(byTags.services[edge.from].spanCount == 2);
+    REQUIRE(byTags.services[edge.to].spanCount == 1);
+    REQUIRE(edge.calls.size() == 1);
+    REQUIRE(edge.calls.front().span->operationName == trace::Symbol::intern("b"));
+}
+
+TEST_CASE("query spans by time window", "[graph]")
+{
+    const auto sample = graph::TraceGraph::parseGraph(readAll("hotroad_rachel.json"), nullptr, 1);
+    REQUIRE(sample != nullptr);
+
+    auto &tr = *sample->traces.front();
+    const auto &index = tr.intervals();
+    REQUIRE(index.size() == tr.spans.size());
+    REQUIRE(&tr.intervals() == &index);
+
+    using us = std::chrono::microseconds;
+    const auto begin = tr.root->startTime;
+    const auto end = begin + tr.root->duration;
+    REQUIRE(index.count(begin, end) == tr.spans.size());
+    REQUIRE(index.count(end, end + us(10)) == 0);
+    REQUIRE(index.query(begin, begin).empty());
+
+    for (const auto window : {us(1), us(1000), us(50000)}) {
+        for (auto from = begin - window; from < end; from += tr.root->duration / 7) {
+            const auto to = from + window;
+
+            std::vector<const graph::Span *> expected;
+            for (const auto &span : tr.spans) {
+                const auto spanEnd = std::max(span.startTime + span.duration,
+                                              span.startTime + us(1));
+                if (span.startTime < to && spanEnd > from) {
+                    expected.push_back(&span);
+                }
+            }
+
+            auto spans = index.query(from, to);
+            REQUIRE(index.count(from, to) == expected.size());
+            REQUIRE(std::is_sorted(spans.cbegin(), spans.cend(), [](auto *a, auto *b) {
+                return a->startTime < b->startTime;
+            }));
+
+            std::sort(spans.begin(), spans.end());
+            std::sort(expected.begin(), expected.end());
+            REQUIRE(spans == expected);
+        }
+    }
+
+    REQUIRE(graph::IntervalIndex().count(begin, end) == 0);
+}
+
+TEST_CASE("collapse repeated subtrees", "[graph]")
+{
+    // three 'db' calls with a 'conn' child, 'cache', one more 'db' and a 'db' without child
+    const QByteArray data = R"({"data": [{"traceID": "1", "spans": [
+        {"traceID": "1", "spanID": "1", "operationName": "root", "references": [],
+         "startTime": 0, "duration": 1000, "processID": "p1"},
+        {"traceID": "1", "spanID": "2", "operationName": "db", "startTime": 10, "duration": 20,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "3", "operationName": "conn", "startTime": 12, "duration": 3,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "2"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "4", "operationName": "db", "startTime": 40, "duration": 30,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "5", "operationName": "conn", "startTime": 42, "duration": 3,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "4"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "6", "operationName": "db", "startTime": 80, "duration": 10,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "7", "operationName": "conn", "startTime": 82, "duration": 3,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "6"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "8", "operationName": "cache", "startTime": 100, "duration": 5,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p1"},
+        {"traceID": "1", "spanID": "9", "operationName": "db", "startTime": 120, "duration": 40,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "a", "operationName": "conn", "startTime": 122, "duration": 3,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "9"}],
+         "processID": "p2"},
+        {"traceID": "1", "spanID": "b", "operationName": "db", "startTime": 200, "duration": 5,
+         "references": [{"refType": "CHILD_OF", "traceID": "1", "spanID": "1"}],
+         "processID": "p2"}
+        ], "processes": {"p1": {"serviceName": "api"}, "p2": {"serviceName": "db"}}}]})";
+
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 1);
+    REQUIRE(traceGraph != nullptr);
+
+    const auto &tr = *traceGraph->traces.front();
+    const auto &spans = tr.spans;
+    REQUIRE(spans[1].shapeHash == spans[3].shapeHash);
+    REQUIRE(spans[1].shapeHash == spans[8].shapeHash);
+    REQUIRE(spans[1].shapeHash != spans[10].shapeHash);
+    REQUIRE(spans[1].shapeHash != spans[2].shapeHash);
+
+    using us = std::chrono::microseconds;
+
+    std::vector<const graph::Span *> children;
+    const auto groups = graph::SpanGroup::collapseChildren(*tr.root, &children);
+    REQUIRE(children.size() == 6);
+    REQUIRE(groups.size() == 4);
+
+    REQUIRE(groups[0].first == 0);
+    REQUIRE(groups[0].count == 3);
+    REQUIRE(groups[0].minDuration == us(10));
+    REQUIRE(groups[0].maxDuration == us(30));
+    REQUIRE(groups[0].averageDuration() == us(20));
+
+    REQUIRE(children[groups[1].first]->operationName == trace::Symbol::intern("cache"));
+    REQUIRE(groups[1].count == 1);
+    // the same shape after another one starts a new run
+    REQUIRE(groups[2].count == 1);
+    REQUIRE(groups[2].averageDuration() == us(40));
+    REQUIRE(groups[3].first == 5);
+
+    REQUIRE(graph::SpanGroup::collapse({}).empty());
+}
+
+TEST_CASE("order logs by time", "[graph]")
+{
+    const auto data = makeSearchResult(readAll("hotroad_rachel.json"), 8);
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 4);
+    REQUIRE(traceGraph != nullptr);
+
+    std::vector<graph::LogRef> expected;
+    for (const auto &tr : traceGraph->traces) {
+        for (auto &span : tr->spans) {
+            for (quint32 k = 0; k < span.logs.size(); ++k) {
+                expected.push_back({&span, k});
+            }
+        }
+    }
+    REQUIRE_FALSE(expected.empty());
+    // ties keep the order of spans and of the logs of a span
+    std::stable_sort(expected.begin(), expected.end(), [](const auto &a, const auto &b) {
+        return a.record().timestamp < b.record().timestamp;
+    });
+
+    for (const int threadCount : {1, 3, 8}) {
+        const auto order = graph::orderLogs(*traceGraph, threadCount);
+        REQUIRE(order.size() == expected.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            REQUIRE(order[i].span == expected[i].span);
+            REQUIRE(order[i].log == expected[i].log);
+        }
+    }
+
+    REQUIRE(graph::orderLogs(graph::TraceGraph()).empty());
+}
+
+TEST_CASE("search logs", "[graph]")
+{
+    const auto data = makeSearchResult(readAll("hotroad_rachel.json"), 8);
+    const auto traceGraph = graph::TraceGraph::parseGraph(data, nullptr, 4);
+    REQUIRE(traceGraph != nullptr);
+    const auto logs = graph::orderLogs(*traceGraph, 4);
+    REQUIRE_FALSE(logs.empty());
+
+    const auto keeper = trace::Source::fromData(QByteArray());
+    const auto scan = [&](const QByteArray &query) {
+        std::vector<quint32> rows;
+        QByteArray text;
+        for (size_t i = 0; i < logs.size(); ++i) {
+            graph::LogSearchIndex::logText(logs[i].record(), *keeper, &text);
+            if (text.contains(query.toLower())) {
+                rows.push_back(static_cast<quint32>(i));
+            }
+        }
+        return rows;
+    };
+
+    REQUIRE(graph::LogSearchIndex().isEmpty());
+    const auto single = graph::LogSearchIndex::build(logs);
+    const auto sharded = graph::LogSearchIndex::build(logs, 4);
+    REQUIRE_FALSE(single.isEmpty());
+
+    for (const QByteArray query : {"ht", "get", "HTTP request", "event=loading", "no such log"}) {
+        const auto expected = scan(query);
+        REQUIRE(single.search(logs, query) == expected);
+        REQUIRE(sharded.search(logs, query) == expected);
+        // an index that is not built yet scans
+        REQUIRE(graph::LogSearchIndex().search(logs, query) == expected);
+    }
+
+    REQUIRE_FALSE(scan("http request").empty());
+    REQUIRE(scan("no such log").empty());
+}
+
+TEST_CASE("combine row bitmaps", "[graph]")
+{
+    graph::Bitmap all(130, true);
+    REQUIRE(all.size() == 130);
+    REQUIRE(all.count() == 130);
+
+    graph::Bitmap even(130);
+    graph::Bitmap tail(130);
+    for (size_t i = 0; i < 130; ++i) {
+        if (i % 2 == 0) {
+            even.set(i);
+        }
+        if (i >= 100) {
+            tail.set(i);
+        }
+    }
+    REQUIRE(even.count() == 65);
+    REQUIRE(even.test(128));
+    REQUIRE_FALSE(even.test(129));
+
+    auto both = even;
+    both &= tail;
+    std::vector<size_t> rows;
+    both.forEach([&rows](size_t row) { rows.push_back(row); });
+    REQUIRE(rows.size() == 15);
+    REQUIRE(rows.front() == 100);
+    REQUIRE(rows.back() == 128);
+    REQUIRE(std::is_sorted(rows.cbegin(), rows.cend()));
+
+    auto any = even;
+    any |= tail;
+    REQUIRE(any.count() == 50 + 30);
+    all &= any;
+    REQUIRE(all.count() == any.count());
+}
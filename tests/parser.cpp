@@ -1,28 +1,63 @@
-#include <QtCore/QFile>
-
 #include <catch2/catch_test_macros.hpp>
 
+#include "trace/json_reader.h"
+#include "trace/structural_scanner.h"
 #include "trace/trace.h"
 
+#include "test_data.h"
+
 namespace {
 
-QByteArray readAll(const QString &filename)
+//! flatten the document into one string, every third object member is skipped
+void walk(trace::JsonReader &reader, std::string &out)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCritical() << "file not open" << filename << file.errorString();
-        return {};
-    }
+    using Token = trace::JsonReader::Token;
 
-    auto data = file.readAll();
-    file.close();
-
-    return data;
+    switch (reader.peek()) {
+    case Token::BeginObject: {
+        reader.beginObject();
+        std::string_view key;
+        for (int i = 0; reader.nextKey(&key); ++i) {
+            out.append(key).append(":");
+            if (i % 3 == 2) {
+                reader.skipValue();
+            } else {
+                walk(reader, out);
+            }
+        }
+        out += '}';
+        break;
+    }
+    case Token::BeginArray:
+        reader.beginArray();
+        while (reader.nextElement()) {
+            walk(reader, out);
+        }
+        out += ']';
+        break;
+    case Token::String: {
+        std::string_view value;
+        reader.readString(&value);
+        out.append(value).append(",");
+        break;
+    }
+    case Token::Number: {
+        double value = 0;
+        reader.readDouble(&value);
+        out += std::to_string(value);
+        break;
+    }
+    default:
+        reader.skipValue();
+        break;
+    }
 }
 
 } // namespace
 
 using namespace trace;
+using tests::makeSearchResult;
+using tests::readAll;
 
 TEST_CASE("parse valid trace", "[trace]")
 {
@@ -58,4 +93,245 @@ TEST_CASE("parse valid trace", "[trace]")
         REQUIRE_FALSE(iter.value().name.isEmpty());
         REQUIRE_FALSE(iter.value().tags.isEmpty());
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("parse invalid json", "[trace]")
+{
+    const QByteArray documents[] = {
+        R"({"data": [{"traceID": "1", "spans": [)",
+        R"([{"traceID": "1"}])",
+        R"({"data": {"traceID": "1"}})",
+        R"({"data": [1, 2]})",
+        R"({"data": []} trailing)",
+        R"({"skipped": [1}, "data": []})",
+        R"({"data": [{"traceID": "1", "spans": [{"traceID": "1", "spanID": "xyz"}],
+            "processes": {"p1": {"serviceName": "a"}}}]})",
+        R"({"data": [{"traceID": "1", "spans": [{"traceID": "1",
+            "spanID": "123456789abcdef01"}], "processes": {"p1": {"serviceName": "a"}}}]})",
+        R"({"data": [{"traceID": "1", "spans": [{"traceID": "1", "spanID": "2",
+            "logs": [{"timestamp": 1, "fields": {"key": "event"}}]}],
+            "processes": {"p1": {"serviceName": "a"}}}]})",
+        R"({"data": [{"traceID": "1", "spans": [{"traceID": "1", "spanID": "2",
+            "logs": [1]}], "processes": {"p1": {"serviceName": "a"}}}]})",
+    };
+
+    for (const auto &data : documents) {
+        TraceParseError error;
+        auto doc = TraceDocument::parseDocument(data, &error);
+
+        REQUIRE(error.error == TraceParseError::ParseError::InvalidJSON);
+        REQUIRE(doc.traces.isEmpty());
+    }
+}
+
+TEST_CASE("parse fields in any order", "[trace]")
+{
+    const QByteArray data = R"({
+        "data": [{
+            "processes": {"p1": {"tags": [], "serviceName": "front\"end"}},
+            "spans": [{
+                "processID": "p1",
+                "tags": [{"value": 42, "key": "answer", "type": "int64"},
+                         {"type": "bool", "value": true, "key": "error"},
+                         {"key": "ratio", "type": "float64", "value": 0.25},
+                         {"key": "payload", "type": "binary", "value": "AAEC"},
+                         {"key": "raw", "type": "uint64", "value": 7}],
+                "logs": [{"fields": [{"value": "café", "type": "string", "key": "event"}],
+                          "timestamp": 1661173878534672}],
+                "spanID": "5974e87c189857fa",
+                "unknown": {"nested": [1, "]"]},
+                "traceID": "03484e45e3c853ab"
+            }],
+            "traceID": "03484e45e3c853ab"
+        }]
+    })";
+
+    TraceParseError error;
+    auto doc = TraceDocument::parseDocument(data, &error);
+
+    REQUIRE(error.error == TraceParseError::ParseError::NoError);
+    REQUIRE(doc.traces.size() == 1);
+
+    const auto &trace = doc.traces[0];
+    REQUIRE(trace.process[StringRef::view("p1")].name.toString() == QString("front\"end"));
+    REQUIRE(trace.spans.size() == 1);
+
+    const auto &span = trace.spans[0];
+    REQUIRE(span.processID == "p1");
+    REQUIRE(span.tags.size() == 5);
+    REQUIRE(span.tags[0].key == Symbol::intern("answer"));
+    REQUIRE(span.tags[0].value.toInt64() == 42);
+    REQUIRE(span.tags[1].value.toBool());
+    REQUIRE(span.tags[2].value.type() == Value::Type::Float64);
+    REQUIRE(span.tags[2].value.toDouble() == 0.25);
+    REQUIRE(span.tags[3].value.type() == Value::Type::Binary);
+    REQUIRE(span.tags[3].value.toString() == "AAEC");
+    // unknown types keep the json value
+    REQUIRE(span.tags[4].value.toInt64() == 7);
+    // fields of logs stay raw json until asked for
+    REQUIRE(span.logs.size() == 1);
+    REQUIRE(span.logs[0].timestamp.time_since_epoch().count() == 1661173878534672);
+    REQUIRE(span.logs[0].rawFields.startsWith("[{"));
+    REQUIRE(span.logs[0].level.isEmpty());
+    REQUIRE_FALSE(span.logs[0].hasError);
+    const auto fields = LogRecord::parseFields(*trace.source, span.logs[0].rawFields);
+    REQUIRE(fields.size() == 1);
+    REQUIRE(fields[0].value.toString() == QString::fromUtf8("caf\xC3\xA9"));
+}
+
+TEST_CASE("parse traces in parallel", "[trace]")
+{
+    auto data = makeSearchResult(readAll("hotroad_rachel.json"), 8);
+    REQUIRE_FALSE(data.isEmpty());
+
+    TraceParseError error;
+    auto doc = TraceDocument::parseDocument(data, &error, 4);
+
+    REQUIRE(error.error == TraceParseError::ParseError::NoError);
+    REQUIRE(doc.traces.size() == 8);
+    for (int i = 0; i < doc.traces.size(); ++i) {
+        REQUIRE(doc.traces[i].traceID.toString().toLongLong(nullptr, 16) == i);
+        REQUIRE(doc.traces[i].spans.size() == 51);
+    }
+}
+
+TEST_CASE("parse mapped file", "[trace]")
+{
+    REQUIRE(Source::mapFile("missing.json") == nullptr);
+
+    const auto source = Source::mapFile("hotroad_rachel.json");
+    REQUIRE(source != nullptr);
+    REQUIRE(source->isMapped());
+
+    TraceParseError error;
+    auto doc = TraceDocument::parseDocument(source, &error);
+    REQUIRE(error.error == TraceParseError::ParseError::NoError);
+    REQUIRE(doc.traces.size() == 1);
+
+    const auto &trace = doc.traces[0];
+    REQUIRE(trace.source == source);
+    REQUIRE(trace.spans.size() == 51);
+
+    // strings without escapes point into the mapping
+    const auto data = source->data();
+    const auto processID = trace.spans[0].processID.utf8();
+    REQUIRE(processID.data() >= data.data());
+    REQUIRE(processID.data() + processID.size() <= data.data() + data.size());
+
+    const QByteArray escaped = R"({"data": [{"traceID": "a\u0062", "spans": [{"traceID": "ab",
+        "spanID": "1", "processID": "p1"}], "processes": {"p1": {"serviceName": "s"}}}]})";
+    doc = TraceDocument::parseDocument(escaped, &error);
+    REQUIRE(doc.traces.size() == 1);
+    REQUIRE(doc.traces[0].traceID == TraceID(0, 0xab));
+    REQUIRE(doc.traces[0].traceID == doc.traces[0].spans[0].traceID);
+}
+
+TEST_CASE("decode ids", "[trace]")
+{
+    REQUIRE(SpanID::fromHex("5974e87c189857fa").value() == 0x5974e87c189857faULL);
+    REQUIRE(SpanID::fromHex("5974E87C189857FA") == SpanID(0x5974e87c189857faULL));
+    REQUIRE(SpanID::fromHex("1").toString() == "0000000000000001");
+    REQUIRE(SpanID::fromHex("").isEmpty());
+    REQUIRE(SpanID::fromHex("xyz").isEmpty());
+    REQUIRE(SpanID::fromHex("10000000000000000").isEmpty());
+
+    const auto wide = TraceID::fromHex("0af7651916cd43dd8448eb211c80319c");
+    REQUIRE(wide.high() == 0x0af7651916cd43ddULL);
+    REQUIRE(wide.low() == 0x8448eb211c80319cULL);
+    REQUIRE(wide.toString() == "0af7651916cd43dd8448eb211c80319c");
+    REQUIRE(TraceID::fromHex("03484e45e3c853ab").toString() == "03484e45e3c853ab");
+    REQUIRE(TraceID::fromHex("03484e45e3c853ab") < wide);
+    REQUIRE(TraceID::fromHex("0af7651916cd43dd8448eb211c80319c0").isEmpty());
+
+    // the width of the input is kept when the high half is zero
+    const auto zeroHigh = TraceID::fromHex("000000000000000003484e45e3c853ab");
+    REQUIRE(zeroHigh.isWide());
+    REQUIRE(zeroHigh.toString() == "000000000000000003484e45e3c853ab");
+    REQUIRE(zeroHigh == TraceID::fromHex("03484e45e3c853ab"));
+    REQUIRE_FALSE(TraceID::fromHex("03484e45e3c853ab").isWide());
+}
+
+TEST_CASE("scan structural index", "[trace]")
+{
+    using Implementation = StructuralScanner::Implementation;
+
+    const auto data = makeSearchResult(readAll("hotroad_rachel.json"), 16);
+    REQUIRE_FALSE(data.isEmpty());
+
+    const std::string_view view(data.constData(), static_cast<size_t>(data.size()));
+
+    std::string expected;
+    JsonReader plain(view);
+    walk(plain, expected);
+    REQUIRE(plain.atEnd());
+
+    const Implementation implementations[] = {
+        Implementation::Scalar,
+        Implementation::Sse42,
+        Implementation::Avx2,
+    };
+
+    for (auto implementation : implementations) {
+        if (implementation > StructuralScanner::bestImplementation()) {
+            break;
+        }
+
+        std::string actual;
+        JsonReader indexed(view, implementation);
+        walk(indexed, actual);
+
+        REQUIRE(indexed.atEnd());
+        REQUIRE(actual == expected);
+    }
+
+    JsonReader broken(R"(["a\"b", "c)" "\n" R"("])", StructuralScanner::bestImplementation());
+    std::string out;
+    walk(broken, out);
+    REQUIRE(broken.hasError());
+
+    // a skipped container closes with the kind of bracket it was opened with
+    const std::string_view mismatched = R"({"a": [1, {"b": 2]}, "c": 3})";
+    JsonReader plainMismatch(mismatched);
+    JsonReader indexedMismatch(mismatched, StructuralScanner::bestImplementation());
+    for (auto *reader : {&plainMismatch, &indexedMismatch}) {
+        std::string_view key;
+        REQUIRE(reader->beginObject());
+        REQUIRE(reader->nextKey(&key));
+        REQUIRE_FALSE(reader->skipValue());
+        REQUIRE(reader->hasError());
+    }
+}
+
+TEST_CASE("store tag values", "[trace]")
+{
+    REQUIRE(sizeof(Value) == 16);
+    REQUIRE(Value().isNull());
+    REQUIRE(Value::fromInt64(-5).toString() == "-5");
+    REQUIRE(Value::fromDouble(1.5).toString() == "1.5");
+    REQUIRE(Value::fromBool(false).toString() == "false");
+
+    const QByteArray text = "a string longer than inline storage";
+    const auto view = Value::fromView(text);
+    REQUIRE(view.utf8().data() == text.constData());
+
+    // copies do not depend on the original bytes
+    auto copy = Value::fromUtf8(QByteArray(text));
+    auto shortCopy = Value::fromString(QString("short"));
+    REQUIRE(copy == view);
+    REQUIRE(copy.toString() == QString::fromUtf8(text));
+    REQUIRE(shortCopy.toString() == "short");
+    REQUIRE(shortCopy != view);
+    REQUIRE(Value::fromUtf8(text, Value::Type::Binary) != view);
+}
+
+TEST_CASE("intern symbols", "[trace]")
+{
+    const auto a = Symbol::intern("span.kind");
+    const auto b = Symbol::intern(QString("span.kind"));
+
+    REQUIRE(a == b);
+    REQUIRE(a != Symbol::intern("component"));
+    REQUIRE(a.toString() == "span.kind");
+    REQUIRE(Symbol::intern("").isEmpty());
+    REQUIRE(Symbol().toString().isEmpty());
+}
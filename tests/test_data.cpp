@@ -0,0 +1,46 @@
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+
+#include "trace/trace.h"
+
+#include "test_data.h"
+
+namespace tests {
+
+QByteArray readAll(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCritical() << "file not open" << filename << file.errorString();
+        return {};
+    }
+
+    auto data = file.readAll();
+    file.close();
+
+    return data;
+}
+
+QByteArray makeSearchResult(const QByteArray &data, int count)
+{
+    const auto rawTraces = trace::TraceDocument::split(data);
+    if (rawTraces.size() != 1) {
+        return {};
+    }
+
+    const QByteArray traceID = "03484e45e3c853ab";
+    QByteArray result = R"({"data": [)";
+    for (int i = 0; i < count; ++i) {
+        auto rawTrace = rawTraces.front().toByteArray();
+        rawTrace.replace(traceID, QByteArray::number(i, 16).rightJustified(traceID.size(), '0'));
+        if (i != 0) {
+            result += ',';
+        }
+        result += rawTrace;
+    }
+    result += "]}";
+
+    return result;
+}
+
+} // namespace tests
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+namespace tests {
+
+//! content of a file in testdata, empty when it can not be read
+QByteArray readAll(const QString &filename);
+
+//! search result of count copies of the single trace of data, with trace IDs 0 to count - 1
+QByteArray makeSearchResult(const QByteArray &data, int count);
+
+} // namespace tests